@@ -19,10 +19,39 @@ const char* Visibility::str() {
     return "";
 }
 
+static const std::pair<const char*, int> fn_attribute_names[] = {
+    { "inline",   FnAttributes::Inline   },
+    { "noinline", FnAttributes::NoInline },
+    { "hot",      FnAttributes::Hot      },
+    { "cold",     FnAttributes::Cold     },
+};
+
+int FnAttributes::find(Symbol name) {
+    for (auto&& attribute : fn_attribute_names) {
+        if (name == attribute.first)
+            return attribute.second;
+    }
+    return None;
+}
+
+std::string FnAttributes::str() const {
+    if (empty())
+        return "";
+    std::string result = "#[";
+    for (auto&& attribute : fn_attribute_names) {
+        if (attributes_ & attribute.second) {
+            if (result.size() > 2)
+                result += ", ";
+            result += attribute.first;
+        }
+    }
+    return result + "] ";
+}
+
 std::string PtrASTType::prefix() const {
     switch (tag()) {
-        case Borrowed: return "&";
-        case Mut:      return "&mut";
+        case Borrowed: return is_restrict() ? "&restrict " : "&";
+        case Mut:      return is_restrict() ? "&mut restrict " : "&mut";
         case Owned:    return "~";
     }
     THORIN_UNREACHABLE;
@@ -53,6 +82,19 @@ const Expr* Expr::skip_rvalue() const {
 
 uint64_t LiteralExpr::get_u64() const { return thorin::bcast<uint64_t, thorin::Box>(box()); }
 
+const FnDecl* MapExpr::primop_decl() const {
+    auto callee = lhs()->skip_rvalue();
+    if (auto type_app = callee->isa<TypeAppExpr>())
+        callee = type_app->lhs()->skip_rvalue();
+    if (auto path = callee->isa<PathExpr>()) {
+        if (auto fn_decl = path->value_decl() ? path->value_decl()->isa<FnDecl>() : nullptr) {
+            if (fn_decl->is_extern() && fn_decl->abi() == "\"thorin\"")
+                return fn_decl;
+        }
+    }
+    return nullptr;
+}
+
 bool IfExpr::has_else() const {
     if (auto block = else_expr_->isa<BlockExpr>())
         return !block->empty();
@@ -120,6 +162,54 @@ bool ForExpr::has_side_effect() const { return true; }
 
 //------------------------------------------------------------------------------
 
+/*
+ * speculation_cost
+ */
+
+static size_t add_cost(size_t a, size_t b) {
+    if (a == Expr::no_speculation || b == Expr::no_speculation)
+        return Expr::no_speculation;
+    return a + b;
+}
+
+size_t LiteralExpr::speculation_cost() const { return 0; }
+size_t CharExpr::speculation_cost() const { return 0; }
+
+size_t PathExpr::speculation_cost() const {
+    // reading a local is at most a load from its slot
+    if (auto local = value_decl() ? value_decl()->isa<LocalDecl>() : nullptr)
+        return local->is_mut() ? 1 : 0;
+    return no_speculation;
+}
+
+size_t PrefixExpr::speculation_cost() const {
+    switch (tag()) {
+        case ADD: return rhs()->speculation_cost();
+        case SUB:
+        case NOT: return add_cost(rhs()->speculation_cost(), 1);
+        default:  return no_speculation;
+    }
+}
+
+size_t InfixExpr::speculation_cost() const {
+    // division by zero traps
+    if (Token::is_assign((TokenTag) tag()) || tag() == DIV || tag() == REM)
+        return no_speculation;
+    return add_cost(add_cost(lhs()->speculation_cost(), rhs()->speculation_cost()), 1);
+}
+
+size_t CastExpr::speculation_cost() const { return add_cost(src()->speculation_cost(), 1); }
+size_t RValueExpr::speculation_cost() const { return src()->speculation_cost(); }
+size_t BlockExpr::speculation_cost() const { return stmts().empty() ? expr()->speculation_cost() : no_speculation; }
+
+size_t IfExpr::speculation_cost() const {
+    if (!has_else())
+        return no_speculation;
+    return add_cost(add_cost(cond()->speculation_cost(), then_expr()->speculation_cost()), add_cost(else_expr()->speculation_cost(), 1));
+}
+
+//------------------------------------------------------------------------------
+
 /*
  * take_address
  */
@@ -1,6 +1,7 @@
 #ifndef IMPALA_AST_H
 #define IMPALA_AST_H
 
+#include <map>
 #include <vector>
 
 #include "thorin/util/array.h"
@@ -107,6 +108,69 @@ private:
     int visibility_;
 };
 
+/// Attributes of a function: <tt>#[inline, cold] fn f() ...</tt>; they are hints for the backend only.
+class FnAttributes {
+public:
+    enum {
+        None     = 0,
+        Inline   = 1 << 0,
+        NoInline = 1 << 1,
+        Hot      = 1 << 2,
+        Cold     = 1 << 3,
+    };
+
+    FnAttributes(int attributes = None)
+        : attributes_(attributes)
+    {}
+
+    /// The attribute called @p name or @p None if there is no such attribute.
+    static int find(Symbol name);
+    std::string str() const;
+    bool empty() const { return attributes_ == None; }
+    bool is_inline() const { return attributes_ & Inline; }
+    bool is_noinline() const { return attributes_ & NoInline; }
+    bool is_hot() const { return attributes_ & Hot; }
+    bool is_cold() const { return attributes_ & Cold; }
+    bool operator==(FnAttributes other) const { return attributes_ == other.attributes_; }
+    bool operator!=(FnAttributes other) const { return attributes_ != other.attributes_; }
+    FnAttributes& operator|=(int attributes) { attributes_ |= attributes; return *this; }
+
+private:
+    int attributes_;
+};
+
+/// What the LLVM backend has to know about a function beyond its Thorin continuation.
+struct FnHints {
+    FnAttributes attributes;
+    std::vector<bool> noalias; ///< one entry per non-continuation param if any of them is a @c restrict pointer - empty otherwise
+
+    bool empty() const { return attributes.empty() && noalias.empty(); }
+    bool operator==(const FnHints& other) const { return attributes == other.attributes && noalias == other.noalias; }
+    bool operator!=(const FnHints& other) const { return !(*this == other); }
+};
+
+/// What Thorin cannot tell the LLVM backend about functions, globals and slots.
+struct BackendHints {
+    std::map<std::string, FnHints> def_fns;     ///< keyed by the location and name of the function's continuation, which survive Thorin's cleanups
+    std::map<std::string, uint32_t> def_aligns; ///< alignment of globals and slots keyed like @p def_fns
+    std::map<std::string, FnHints> fns;         ///< keyed by the name of the LLVM function - see @c resolve
+    std::map<std::string, uint32_t> aligns;     ///< keyed by the name of the LLVM global or alloca - see @c resolve
+    bool has_stand_ins = false; ///< whether there are calls of functions with one of the prefixes below
+
+    bool empty() const { return fns.empty() && aligns.empty() && !has_stand_ins; }
+    /// Functions whose name starts with this stand in for stores with @c !nontemporal metadata; they take the pointer and the value.
+    static const char* nontemporal_store_prefix() { return "impala.nontemporal_store."; }
+    /// Stand-ins for @c llvm.masked.load; they take the pointer to the vector, the mask and the value of the masked-off lanes.
+    static const char* masked_load_prefix() { return "impala.masked_load."; }
+    /// Stand-ins for @c llvm.masked.store; they take the pointer to the vector, the vector and the mask.
+    static const char* masked_store_prefix() { return "impala.masked_store."; }
+    /// Stand-ins for @c llvm.masked.gather; they take the pointer to the array, the vector of indices, the mask and the value of the masked-off lanes.
+    static const char* gather_prefix() { return "impala.gather."; }
+};
+
+/// Streams <tt>#[align(N)] </tt> - nothing if @p align is 0.
+std::ostream& stream_align(std::ostream&, uint32_t align);
+
 /// Mixin for all entities which have a list of @p TypeParam%s: [T1, T2 : A + B[...], ...].
 class ASTTypeParamList {
 public:
@@ -306,9 +370,10 @@ class PtrASTType : public ASTType {
 public:
     enum Tag { Borrowed, Mut, Owned };
 
-    PtrASTType(Location location, Tag tag, int addr_space, const ASTType* referenced_ast_type)
+    PtrASTType(Location location, Tag tag, bool restricted, int addr_space, const ASTType* referenced_ast_type)
         : ASTType(location)
         , tag_(tag)
+        , restricted_(restricted)
         , addr_space_(addr_space)
         , referenced_ast_type_(referenced_ast_type)
     {}
@@ -316,6 +381,8 @@ public:
     Tag tag() const { return tag_; }
     std::string prefix() const;
     const ASTType* referenced_ast_type() const { return referenced_ast_type_.get(); }
+    /// <tt>&restrict T</tt> or <tt>&mut restrict T</tt>.
+    bool is_restrict() const { return restricted_; }
     int addr_space() const { return addr_space_; }
 
     void bind(NameSema&) const override;
@@ -326,6 +393,7 @@ private:
     void check(TypeSema&) const override;
 
     Tag tag_;
+    bool restricted_;
     int addr_space_;
     std::unique_ptr<const ASTType> referenced_ast_type_;
 };
@@ -582,6 +650,10 @@ public:
     const Fn* fn() const { return fn_; }
     void take_address() const { is_address_taken_ = true; }
     void emit(CodeGen&, const thorin::Def*) const;
+    /// Uses the already initialized @p slot as storage of this local - immutable ones are loaded on each use then.
+    void emit_slot(CodeGen&, const thorin::Def* slot) const;
+    /// Whether @p def() is a slot - always the case for mutable locals.
+    bool is_in_slot() const { return is_mut() || is_in_slot_; }
     void bind(NameSema&) const;
 
     std::ostream& stream(std::ostream&) const override;
@@ -593,6 +665,7 @@ private:
 protected:
     mutable const Fn* fn_;
     mutable bool is_address_taken_ = false;
+    mutable bool is_in_slot_ = false;
 
     friend class CodeGen;
     friend class InferSema;
@@ -652,14 +725,16 @@ private:
 
 class Fn : public ASTTypeParamList {
 public:
-    Fn(const Expr* pe_expr, ASTTypeParams&& ast_type_params, Params&& params, const Expr* body)
+    Fn(const Expr* pe_expr, ASTTypeParams&& ast_type_params, Params&& params, const Expr* body, FnAttributes attributes = FnAttributes())
         : ASTTypeParamList(std::move(ast_type_params))
         , pe_expr_(dock(pe_expr_, pe_expr))
         , params_(std::move(params))
+        , attributes_(attributes)
         , body_(dock(body_, body))
     {}
 
     const Expr* pe_expr() const { return pe_expr_.get(); }
+    FnAttributes attributes() const { return attributes_; }
     const Param* param(size_t i) const { return params_[i].get(); }
     ArrayRef<std::unique_ptr<const Param>> params() const { return params_; }
     size_t num_params() const { return params_.size(); }
@@ -667,11 +742,14 @@ public:
     thorin::Continuation* continuation() const { return continuation_; }
     const thorin::Param* ret_param() const { return ret_param_; }
     const thorin::Def* frame() const { return frame_; }
+    /// Is a loop continuation of this @p Fn used other than for a direct jump? Then mutable locals must live in memory.
+    bool has_escaping_continuation() const { return has_escaping_continuation_; }
     std::ostream& stream_params(std::ostream& p, bool returning) const;
     void fn_bind(NameSema&) const;
     const Type* check_body(TypeSema&) const;
     thorin::Continuation* fn_emit_head(CodeGen&, Location) const;
     void fn_emit_body(CodeGen&, Location) const;
+    FnHints fn_hints() const;
 
     virtual const FnType* fn_type() const = 0;
     virtual Symbol fn_symbol() const = 0;
@@ -679,12 +757,16 @@ public:
 protected:
     std::unique_ptr<const Expr> pe_expr_;
     Params params_;
+    FnAttributes attributes_;
     mutable thorin::Continuation* continuation_ = nullptr;
     mutable const thorin::Param* ret_param_ = nullptr;
     mutable const thorin::Def* frame_ = nullptr;
+    mutable bool has_escaping_continuation_ = false;
 
 private:
     std::unique_ptr<const Expr> body_;
+
+    friend class TypeSema;
 };
 
 //------------------------------------------------------------------------------
@@ -714,6 +796,8 @@ public:
     {}
 
     Visibility visibility() const { return visibility_; }
+    /// Is this @p Item unreachable from @c main and @c extern functions? Then it is neither analyzed nor emitted.
+    bool is_dead() const { return dead_; }
     virtual void bind(NameSema&) const = 0;
     virtual void emit_head(CodeGen&) const {};
     virtual void emit(CodeGen&) const = 0;
@@ -724,9 +808,11 @@ private:
     virtual void check(TypeSema&) const = 0;
 
     Visibility visibility_;
+    mutable bool dead_ = false;
 
     friend class CodeGen;
     friend class InferSema;
+    friend class NameSema;
     friend class TypeSema;
 };
 
@@ -865,12 +951,16 @@ private:
 
 class StructDecl : public TypeDeclItem {
 public:
-    StructDecl(Location location, Visibility vis, const Identifier* id,
+    StructDecl(Location location, Visibility vis, uint32_t align, const Identifier* id,
                ASTTypeParams&& ast_type_params, FieldDecls&& field_decls)
         : TypeDeclItem(location, vis, id, std::move(ast_type_params))
+        , align_(align)
         , field_decls_(std::move(field_decls))
     {}
 
+    /// Alignment of all globals and slots holding this struct by value as given by <tt>#[align(N)]</tt> - 0 if there is none.
+    uint32_t align() const { return align_; }
+
     size_t num_field_decls() const { return field_decls_.size(); }
     const FieldDecls& field_decls() const { return field_decls_; }
     const FieldTable& field_table() const { return field_table_; }
@@ -889,6 +979,7 @@ private:
     const Type* infer_head(InferSema&) const override;
     void check(TypeSema&) const override;
 
+    uint32_t align_;
     FieldDecls field_decls_;
     mutable FieldTable field_table_;
 };
@@ -962,12 +1053,15 @@ private:
 
 class StaticItem : public ValueItem {
 public:
-    StaticItem(Location location, Visibility vis, bool mut, const Identifier* id,
+    StaticItem(Location location, Visibility vis, uint32_t align, bool mut, const Identifier* id,
                const ASTType* ast_type, const Expr* init)
         : ValueItem(location, vis, mut, id, std::move(ast_type))
+        , align_(align)
         , init_(dock(init_, init))
     {}
 
+    /// As given by <tt>#[align(N)]</tt> - 0 if there is none.
+    uint32_t align() const { return align_; }
     const Expr* init() const { return init_.get(); }
 
     void bind(NameSema&) const override;
@@ -980,15 +1074,17 @@ private:
     const Type* infer_head(InferSema&) const override;
     void check(TypeSema&) const override;
 
+    uint32_t align_;
     std::unique_ptr<const Expr> init_;
+    mutable bool is_emitted_ = false;
 };
 
 class FnDecl : public ValueItem, public Fn {
 public:
-    FnDecl(Location location, Visibility vis, bool is_extern, Symbol abi, const Expr* pe_expr, Symbol export_name,
+    FnDecl(Location location, Visibility vis, FnAttributes attributes, bool is_extern, Symbol abi, const Expr* pe_expr, Symbol export_name,
            const Identifier* id, ASTTypeParams&& ast_type_params, Params&& params, const Expr* body)
         : ValueItem(location, vis, /*mut*/ false, id, /*ast_type*/ nullptr)
-        , Fn(pe_expr, std::move(ast_type_params), std::move(params), body)
+        , Fn(pe_expr, std::move(ast_type_params), std::move(params), body, attributes)
         , abi_(abi)
         , export_name_(export_name)
         , is_extern_(is_extern)
@@ -1008,6 +1104,8 @@ public:
     void bind(NameSema&) const override;
     void emit_head(CodeGen&) const override;
     void emit(CodeGen&) const override;
+    /// Emits the body of this generic function for the instance @p continuation.
+    void emit_instance(CodeGen&, thorin::Continuation* continuation) const;
     std::ostream& stream(std::ostream&) const override;
 
 private:
@@ -1096,12 +1194,19 @@ public:
 
     virtual ~Expr() { assert(back_ref_ != nullptr); }
 
+    static const size_t no_speculation = size_t(-1);
+
     const thorin::Def* extra() const { return extra_; }
 
     const Expr* skip_rvalue() const;
 
     virtual void write() const {}
     virtual bool has_side_effect() const { return false; }
+    /**
+     * Number of operations needed to evaluate this @p Expr unconditionally.
+     * @p no_speculation if this @p Expr may trap or has side effects.
+     */
+    virtual size_t speculation_cost() const { return no_speculation; }
     virtual void take_address() const {}
     virtual void bind(NameSema&) const = 0;
     virtual const thorin::Def* lemit(CodeGen&) const;
@@ -1211,6 +1316,7 @@ public:
     uint64_t get_u64() const;
     PrimTypeTag literal2type() const;
 
+    size_t speculation_cost() const override;
     void bind(NameSema&) const override;
     const thorin::Def* remit(CodeGen&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -1234,6 +1340,7 @@ public:
     Symbol symbol() const { return symbol_; }
     char value() const { return value_; }
 
+    size_t speculation_cost() const override;
     void bind(NameSema&) const override;
     const thorin::Def* remit(CodeGen&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -1302,6 +1409,7 @@ public:
         return path_->decl() && path_->decl()->is_value_decl() ? path_->decl() : nullptr;
     }
 
+    size_t speculation_cost() const override;
     void write() const override;
     void take_address() const override;
     void bind(NameSema&) const override;
@@ -1341,6 +1449,7 @@ public:
 
     void write() const override;
     bool has_side_effect() const override;
+    size_t speculation_cost() const override;
     void bind(NameSema&) const override;
     const thorin::Def* lemit(CodeGen&) const override;
     const thorin::Def* remit(CodeGen&) const override;
@@ -1374,6 +1483,7 @@ public:
     const Expr* rhs() const { return rhs_.get(); }
 
     bool has_side_effect() const override;
+    size_t speculation_cost() const override;
     void bind(NameSema&) const override;
     const thorin::Def* remit(CodeGen&) const override;
     void emit_branch(CodeGen&, thorin::Continuation*, thorin::Continuation*) const override;
@@ -1460,6 +1570,7 @@ public:
 
     const Expr* src() const { return src_.get(); }
     void write() const override;
+    size_t speculation_cost() const override;
 
 private:
     const thorin::Def* remit(CodeGen&) const override;
@@ -1518,6 +1629,7 @@ public:
     }
 
     bool has_side_effect() const override;
+    size_t speculation_cost() const override;
 
     void bind(NameSema&) const override { THORIN_UNREACHABLE; }
     std::ostream& stream(std::ostream&) const override;
@@ -1555,6 +1667,10 @@ public:
 
     const Expr* value() const { return value_.get(); }
     uint64_t count() const { return count_; }
+    /// Fills a fresh slot named after @p dbg by a loop and returns it - @c nullptr if the array is built as one value instead.
+    const thorin::Def* emit_slot(CodeGen&, thorin::Debug dbg) const;
+    /// Whether the repeated value is zero - the backend zero-initializes globals of bottom.
+    bool is_zero(CodeGen&) const;
 
     void bind(NameSema&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -1562,6 +1678,7 @@ public:
 private:
     const Type* infer(InferSema&) const override;
     void check(TypeSema&) const override;
+    const thorin::Def* lemit(CodeGen&) const override;
     const thorin::Def* remit(CodeGen&) const override;
 
     std::unique_ptr<const Expr> value_;
@@ -1718,6 +1835,8 @@ public:
     {}
 
     const Expr* lhs() const { return lhs_.get(); }
+    /// The @c extern @c "thorin" function this calls - @c nullptr if it calls anything else.
+    const FnDecl* primop_decl() const;
 
     void write() const override;
     bool has_side_effect() const override;
@@ -1756,6 +1875,7 @@ public:
     void add_local(const LocalDecl* local) const { locals_.push_back(local); }
 
     bool has_side_effect() const override;
+    size_t speculation_cost() const override;
     void bind(NameSema&) const override;
     const thorin::Def* remit(CodeGen&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -1784,6 +1904,7 @@ public:
     bool has_else() const;
 
     bool has_side_effect() const override;
+    size_t speculation_cost() const override;
     void bind(NameSema&) const override;
     const thorin::Def* remit(CodeGen&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -2113,12 +2234,15 @@ private:
 
 class LetStmt : public Stmt {
 public:
-    LetStmt(Location location, const Ptrn* ptrn, const Expr* init)
+    LetStmt(Location location, uint32_t align, const Ptrn* ptrn, const Expr* init)
         : Stmt(location)
+        , align_(align)
         , ptrn_(ptrn)
         , init_(dock(init_, init))
     {}
 
+    /// Alignment of the slots of the mutable locals in @p ptrn as given by <tt>#[align(N)]</tt> - 0 if there is none.
+    uint32_t align() const { return align_; }
     const Ptrn* ptrn() const { return ptrn_.get(); }
     const Expr* init() const { return init_.get(); }
 
@@ -2130,6 +2254,7 @@ private:
     void infer(InferSema&) const override;
     void check(TypeSema&) const override;
 
+    uint32_t align_;
     std::unique_ptr<const Ptrn> ptrn_;
     std::unique_ptr<const Expr> init_;
 };
@@ -0,0 +1,220 @@
+#include "impala/cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+namespace impala {
+
+static const char* index_magic = "impala-cache-1";
+
+static void make_dir(const std::string& dir) {
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+}
+
+/// Copies @p from to @p to via a temporary file, so readers never see a partial file; returns the number of bytes or -1 on failure.
+static int64_t copy_file(const std::string& from, const std::string& to) {
+    std::ifstream src(from, std::ios::binary);
+    if (!src)
+        return -1;
+
+    auto tmp = to + ".tmp";
+    {
+        std::ofstream dst(tmp, std::ios::binary);
+        if (src.peek() != std::ifstream::traits_type::eof())
+            dst << src.rdbuf();
+        if (!dst)
+            return -1;
+    }
+
+    std::remove(to.c_str());
+    if (std::rename(tmp.c_str(), to.c_str()) != 0)
+        return -1;
+
+    std::ifstream result(to, std::ios::binary | std::ios::ate);
+    return result ? int64_t(result.tellg()) : -1;
+}
+
+CompilationCache::CompilationCache(const std::string& dir, uint64_t max_size)
+    : dir_(dir)
+    , max_size_(max_size)
+{
+    make_dir(dir_);
+    load_index();
+}
+
+void CompilationCache::hash(const std::string& data) {
+    // FNV-1a; the length separates consecutive strings
+    for (auto c : data + '\0' + std::to_string(data.size())) {
+        hash_ ^= uint8_t(c);
+        hash_ *= UINT64_C(1099511628211);
+    }
+}
+
+void CompilationCache::hash_file(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    hash(filename);
+    hash(contents.str());
+}
+
+void CompilationCache::hash_file_stamp(const std::string& filename) {
+    hash(filename);
+    struct stat info;
+    if (!filename.empty() && stat(filename.c_str(), &info) == 0)
+        hash(std::to_string(info.st_size) + ' ' + std::to_string(info.st_mtime));
+}
+
+std::string CompilationCache::binary_path(const void* symbol) {
+#ifdef _WIN32
+    HMODULE module = nullptr;
+    if (symbol != nullptr && !GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                                 static_cast<LPCSTR>(symbol), &module))
+        return "";
+    char path[MAX_PATH];
+    return std::string(path, GetModuleFileNameA(module, path, MAX_PATH));
+#else
+    if (symbol == nullptr) {
+#ifdef __linux__
+        char path[4096];
+        auto size = readlink("/proc/self/exe", path, sizeof(path));
+        return size > 0 ? std::string(path, size) : "";
+#else
+        return "";
+#endif
+    }
+    Dl_info info;
+    return dladdr(symbol, &info) != 0 && info.dli_fname != nullptr ? info.dli_fname : "";
+#endif
+}
+
+std::string CompilationCache::key() const {
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << hash_;
+    return os.str();
+}
+
+uint64_t CompilationCache::size() const {
+    uint64_t result = 0;
+    for (auto&& entry : entries_)
+        result += entry.size;
+    return result;
+}
+
+bool CompilationCache::lookup(const std::string& base_name) {
+    auto key = this->key();
+    auto i = std::find_if(entries_.begin(), entries_.end(), [&] (const Entry& entry) { return entry.key == key; });
+
+    bool hit = i != entries_.end();
+    if (hit) {
+        for (auto&& extension : i->extensions)
+            hit &= copy_file(path(key, extension), base_name + extension) >= 0;
+    }
+
+    if (hit) {
+        ++hits_;
+        i->tick = ++tick_;
+    } else {
+        ++misses_;
+        if (i != entries_.end())
+            entries_.erase(i); // some file got lost
+    }
+
+    save_index();
+    return hit;
+}
+
+void CompilationCache::store(const std::string& base_name, const std::vector<std::string>& extensions) {
+    Entry entry{key(), ++tick_, 0, extensions};
+    for (auto&& extension : extensions) {
+        auto size = copy_file(base_name + extension, path(entry.key, extension));
+        if (size < 0)
+            return;
+        entry.size += size;
+    }
+
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [&] (const Entry& e) { return e.key == entry.key; }), entries_.end());
+    entries_.push_back(entry);
+    evict();
+    save_index();
+}
+
+void CompilationCache::evict() {
+    std::sort(entries_.begin(), entries_.end(), [] (const Entry& a, const Entry& b) { return a.tick > b.tick; });
+
+    // keep the most recently used entries up to max_size_ - but always the newest one
+    uint64_t total = 0;
+    size_t keep = 0;
+    while (keep != entries_.size() && (keep == 0 || total + entries_[keep].size <= max_size_))
+        total += entries_[keep++].size;
+
+    for (size_t i = keep, e = entries_.size(); i != e; ++i) {
+        for (auto&& extension : entries_[i].extensions)
+            std::remove(path(entries_[i].key, extension).c_str());
+    }
+    entries_.resize(keep);
+}
+
+/*
+ * index file:
+ * impala-cache-1
+ * <hits> <misses> <tick>
+ * <key> <tick> <size> <num extensions> <extensions>...
+ */
+
+void CompilationCache::load_index() {
+    std::ifstream index(dir_ + "/index");
+    std::string magic;
+    if (!(index >> magic) || magic != index_magic || !(index >> hits_ >> misses_ >> tick_)) {
+        hits_ = misses_ = tick_ = 0;
+        return;
+    }
+
+    Entry entry;
+    size_t num;
+    while (index >> entry.key >> entry.tick >> entry.size >> num) {
+        entry.extensions.resize(num);
+        for (auto& extension : entry.extensions)
+            index >> extension;
+        entries_.push_back(entry);
+    }
+}
+
+void CompilationCache::save_index() const {
+    // concurrent compilations may race here - the loser merely loses statistics and LRU information
+    auto name = dir_ + "/index";
+    {
+        std::ofstream index(name + ".tmp");
+        index << index_magic << std::endl;
+        index << hits_ << ' ' << misses_ << ' ' << tick_ << std::endl;
+        for (auto&& entry : entries_) {
+            index << entry.key << ' ' << entry.tick << ' ' << entry.size << ' ' << entry.extensions.size();
+            for (auto&& extension : entry.extensions)
+                index << ' ' << extension;
+            index << std::endl;
+        }
+    }
+    std::remove(name.c_str());
+    std::rename((name + ".tmp").c_str(), name.c_str());
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef IMPALA_CACHE_H
+#define IMPALA_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace impala {
+
+/**
+ * Keeps the output files of previous compilations in a directory.
+ * An entry is keyed by a hash of everything that influences the outputs: the input files, the flags, and the compiler and its libraries.
+ * Entries are evicted in least-recently-used order as soon as their total size exceeds the limit.
+ */
+class CompilationCache {
+public:
+    CompilationCache(const std::string& dir, uint64_t max_size);
+
+    /// Adds @p data to the key of the current compilation.
+    void hash(const std::string& data);
+    /// Adds the contents of @p filename to the key of the current compilation.
+    void hash_file(const std::string& filename);
+    /// Adds the size and modification time of @p filename to the key of the current compilation - this identifies binaries cheaply.
+    void hash_file_stamp(const std::string& filename);
+    /// Path of the executable or shared library containing @p symbol - or of the running executable if @p symbol is @c nullptr; empty if unknown.
+    static std::string binary_path(const void* symbol);
+    std::string key() const;
+
+    /// Copies the outputs stored for the current key to @p base_name + extension; returns @c false on a miss.
+    bool lookup(const std::string& base_name);
+    /// Stores the files @p base_name + extension for all @p extensions under the current key.
+    void store(const std::string& base_name, const std::vector<std::string>& extensions);
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t size() const;
+    size_t num_entries() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t tick;
+        uint64_t size;
+        std::vector<std::string> extensions;
+    };
+
+    std::string path(const std::string& key, const std::string& extension) const { return dir_ + "/" + key + extension; }
+    void load_index();
+    void save_index() const;
+    void evict();
+
+    std::string dir_;
+    uint64_t max_size_;
+    uint64_t hash_ = UINT64_C(14695981039346656037); // FNV-1a offset basis
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t tick_ = 0;
+    std::vector<Entry> entries_;
+};
+
+}
+
+#endif
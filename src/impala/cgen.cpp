@@ -123,6 +123,7 @@ private:
             // &[T] -> T*
             // &[T * N] -> T*
             // &T -> T*
+            // &restrict T -> T* __restrict
 
             if (auto array_type = ptr_type->pointee()->isa<ArrayType>()) {
                 if (!ctype_from_impala(array_type->elem_type(), ctype_prefix, ctype_suffix))
@@ -134,6 +135,7 @@ private:
 
             if (!ptr_type->is_mut()) ctype_prefix += " const";
             ctype_prefix += "*";
+            if (ptr_type->is_restrict()) ctype_prefix += " __restrict";
             ctype_suffix = "";
             return true;
         }
@@ -185,6 +187,9 @@ private:
     }
 
     void process_struct_decl(const StructDecl* struct_decl) {
+        if (struct_decl->align() != 0)
+            needs_alignas = true;
+
         // Add all the structures that are referenced in the fields
         for (const auto& field : struct_decl->field_decls()) {
             struct_from_type(field->type(), [this] (const StructDecl* decl) {
@@ -208,6 +213,7 @@ private:
 
 public:
     bool needs_vectors = false;
+    bool needs_alignas = false;
 
     void process_module(const Module* mod) {
         for (const auto& item : mod->items()) {
@@ -274,7 +280,11 @@ public:
                     return false;
                 }
 
-                o << "    " << ctype_pref << ' ' << field->symbol() << ctype_suf << ";\n";
+                // C has no alignment on struct declarations, but aligning the first field raises the one of the struct
+                o << "    ";
+                if (st->align() != 0 && field.get() == st->field_decl(0))
+                    o << "alignas(" << st->align() << ") ";
+                o << ctype_pref << ' ' << field->symbol() << ctype_suf << ";\n";
             }
             o << "};\n" << std::endl;
         }
@@ -348,6 +358,12 @@ bool generate_c_interface(const Module* mod, const CGenOptions& opts, std::ostre
         o << "#include <immintrin.h>\n" << std::endl;
     }
 
+    if (cgen.needs_alignas) {
+        o << "#ifndef __cplusplus\n"
+          << "#include <stdalign.h>\n"
+          << "#endif\n" << std::endl;
+    }
+
     // Export structures
     if (!opts.fns_only && !cgen.generate_structs(o)) {
         return false;
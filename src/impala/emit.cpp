@@ -1,3 +1,13 @@
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef LLVM_SUPPORT
+#include <llvm/Config/llvm-config.h>
+#endif
+
 #include "impala/ast.h"
 
 #include "thorin/continuation.h"
@@ -10,12 +20,29 @@ using namespace thorin;
 
 namespace impala {
 
+/// Identifies @p def across Thorin's cleanups - they rebuild the world, but each def keeps its location and name.
+static std::string def_key(const Def* def) {
+    std::ostringstream os;
+    const Location& location = def->debug();
+    streamf(os, "{} {}", location, def->name());
+    return os.str();
+}
+
 class CodeGen {
 public:
-    CodeGen(World& world)
+    CodeGen(World& world, bool branchless, bool mono)
         : world(world)
+        , branchless(branchless)
+        , mono(mono)
     {}
 
+    static const size_t max_speculation_cost = 8;
+
+    /// Whether @p expr is cheap and safe enough to be evaluated unconditionally and merged with a @c select instead of a branch.
+    bool speculate(const Expr* expr) const {
+        return branchless && expr->type()->isa<PrimType>() && expr->speculation_cost() <= max_speculation_cost;
+    }
+
     /// Continuation of type cn()
     Continuation* basicblock(Debug dbg) { return world.continuation(world.fn_type(), CC::C, Intrinsic::None, dbg); }
 
@@ -39,10 +66,46 @@ public:
 
     const Def* frame() const { assert(cur_fn); return cur_fn->frame(); }
 
+    /// Jumps from @p cur_bb to @p callee; jumps to joins are delayed until all their phis are known.
+    void jump(const Def* callee, Defs args, Debug dbg) {
+        if (auto bb = callee->isa_continuation()) {
+            auto i = blocks_.find(bb);
+            if (i != blocks_.end() && i->second->is_join && !i->second->sealed) {
+                if (!block(cur_bb)->unreachable) {
+                    i->second->preds.push_back(jumps_.size());
+                    jumps_.push_back({cur_bb, bb, std::vector<const Def*>(args.begin(), args.end()), dbg});
+                }
+                return;
+            }
+        }
+        cur_bb->jump(callee, args, dbg);
+    }
+
+    /// @p bb is only entered from @p cur_bb.
+    void set_parent(Continuation* bb) {
+        auto b = block(bb);
+        b->parent = cur_bb;
+        b->unreachable = block(cur_bb)->unreachable;
+    }
+
+    void branch(const Def* cond, Continuation* t, Continuation* f, Debug dbg) {
+        cur_bb->branch(cond, t, f, dbg);
+        set_parent(t);
+        set_parent(f);
+    }
+
+    void match(const Def* val, Continuation* otherwise, Defs defs, ArrayRef<Continuation*> targets, Debug dbg) {
+        cur_bb->match(val, otherwise, defs, targets, dbg);
+        set_parent(otherwise);
+        for (auto target : targets)
+            set_parent(target);
+    }
+
     std::pair<Continuation*, const Def*> call(const Def* callee, Defs args, const thorin::Type* ret_type, Debug dbg) {
         if (ret_type == nullptr) {
-            cur_bb->jump(callee, args, dbg);
+            jump(callee, args, dbg);
             auto next = basicblock(dbg + "_unrechable");
+            block(next)->unreachable = true;
             return std::make_pair(next, nullptr);
         }
 
@@ -60,6 +123,7 @@ public:
         // next is the return continuation
         auto next = world.continuation(world.fn_type(cont_args), dbg);
         next->param(0)->debug().set("mem");
+        set_parent(next);
 
         // create jump to next
         size_t csize = args.size() + 1;
@@ -89,13 +153,52 @@ public:
     }
 
     const Def* load(const Def* ptr, Location location) {
+        if (ssa_vars_.contains(ptr))
+            return read(cur_bb, ptr);
+        auto elem = ssa_elems_.find(ptr);
+        if (elem != ssa_elems_.end())
+            return world.extract(load(elem->second.first, location), elem->second.second, location);
         auto l = world.load(cur_mem, ptr, location);
         cur_mem = world.extract(l, 0_s, location);
         return world.extract(l, 1_s, location);
     }
 
     void store(const Def* ptr, const Def* val, Location location) {
-        cur_mem = world.store(cur_mem, ptr, val, location);
+        auto elem = ssa_elems_.find(ptr);
+        if (ssa_vars_.contains(ptr))
+            block(cur_bb)->values[ptr] = val;
+        else if (elem != ssa_elems_.end())
+            store(elem->second.first, world.insert(load(elem->second.first, location), elem->second.second, val, location), location);
+        else
+            cur_mem = world.store(cur_mem, ptr, val, location);
+    }
+
+    /// Address of the element @p index of the aggregate at @p ptr - merely a handle for @p load and @p store if the aggregate lives in registers.
+    const Def* lea(const Def* ptr, const Def* index, Location location) {
+        auto lea = world.lea(ptr, index, location);
+        if (ssa_vars_.contains(ptr) || ssa_elems_.contains(ptr))
+            ssa_elems_.emplace(lea, std::make_pair(ptr, index));
+        return lea;
+    }
+
+    /// Byte array of a string literal - identical strings share the same @p Def.
+    const Def* string(const std::vector<char>& str, Location location) {
+        auto& def = strings_[std::string(str.begin(), str.end())];
+        if (def == nullptr) {
+            Array<const Def*> args(str.size());
+            for (size_t i = 0, e = args.size(); i != e; ++i)
+                args[i] = world.literal_pu8(str[i], location);
+            def = world.definite_array(args, location);
+        }
+        return def;
+    }
+
+    /// Read-only global initialized with the constant @p init - identical constants share the same global.
+    const Def* const_global(const Def* init, Location location) {
+        auto& global = const_globals_[init];
+        if (global == nullptr)
+            global = world.global(init, /*mutable*/ false, location);
+        return global;
     }
 
     const Def* alloc(const thorin::Type* type, const Def* extra, Debug dbg) {
@@ -106,28 +209,330 @@ public:
         return world.extract(alloc, 1, dbg);
     }
 
+    /*
+     * SSA construction for mutable locals whose address is never taken - see
+     * Braun et al.: Simple and Efficient Construction of Static Single Assignment Form
+     */
+
+    /// Values of @p var are tracked in registers from now on; @p var itself is only used as handle.
+    void promote(const Def* var) { ssa_vars_.insert(var); }
+    /// @p bb is reached via @p jump%s; phis will become additional params of @p bb.
+    void join(Continuation* bb) { block(bb)->is_join = true; block(bb)->sealed = false; }
+    /// All predecessors of @p bb are known.
+    void seal(Continuation* bb);
+    const Def* read(Continuation* bb, const Def* var);
+    /// Seals remaining joins, removes trivial phis and emits the delayed jumps.
+    void finalize();
+
     const thorin::Type* convert(const Type* type) {
-        if (auto t = thorin_type(type))
+        if (auto t = cached_type(type))
             return t;
         auto t = convert_rec(type);
-        return thorin_type(type) = t;
+        return cached_type(type) = t;
+    }
+
+    /// Cache entry of @p type - types mentioning type variables are cached per instance as their meaning depends on the instance currently emitted.
+    const thorin::Type*& cached_type(const Type* type) {
+        if (mono && !type->is_monomorphic())
+            return instance_types_[std::make_pair(type, world.tuple_type(type_args))];
+        return thorin_type(type);
     }
 
     const thorin::Type* convert_rec(const Type*);
 
+    /*
+     * monomorphization
+     */
+
+    /// Instance of the generic @p fn_decl for the thorin types @p args - each instance is only created once.
+    Continuation* instantiate(const FnDecl* fn_decl, ArrayRef<const thorin::Type*> args);
+    /// Emits the bodies of all instances requested so far, including the ones requested meanwhile.
+    void emit_instances();
+
+    /// Records the @p hints of the function @p continuation - they hold for its clones and instances as well.
+    void fn_hints(Continuation* continuation, const FnHints& hints) {
+        if (!hints.empty())
+            fn_hints_.emplace(def_key(continuation), hints);
+    }
+
+    /**
+     * Tells LLVM that @p cond is most likely @p expected via @c llvm.expect.
+     * LLVM turns this into branch weights of the branch on the result, which Thorin's @c branch cannot carry itself.
+     */
+    const Def* expect(const Def* cond, bool expected, Location location) {
+        if (!expect_) {
+            auto b = world.type_bool();
+            expect_ = world.continuation(world.fn_type({ world.mem_type(), b, b, world.fn_type({ world.mem_type(), b }) }), {location, "llvm.expect.i1"});
+        }
+        const Def* result;
+        std::tie(cur_bb, result) = call(expect_, { cur_mem, cond, world.literal_bool(expected, location) }, world.type_bool(), {location, expected ? "likely" : "unlikely"});
+        cur_mem = cur_bb->param(0);
+        return result;
+    }
+
+    /**
+     * Prefetches @p ptr via @c llvm.prefetch.
+     * The intrinsic is overloaded on the address space of the pointer since LLVM 10, so its name carries the mangled type of the <tt>i8*</tt> passed here.
+     * The verifier rejects the plain name in modules that are not re-parsed from text.
+     */
+    void prefetch(const Def* ptr, int rw, int locality, Location location) {
+        auto byte_ptr_type = world.ptr_type(world.type_pu8());
+        if (!prefetch_) {
+#if defined(LLVM_SUPPORT) && LLVM_VERSION_MAJOR >= 15
+            auto name = "llvm.prefetch.p0";
+#elif defined(LLVM_SUPPORT) && LLVM_VERSION_MAJOR < 10
+            auto name = "llvm.prefetch";
+#else
+            auto name = "llvm.prefetch.p0i8";
+#endif
+            auto i32 = world.type_qs32();
+            prefetch_ = world.continuation(world.fn_type({ world.mem_type(), byte_ptr_type, i32, i32, i32, world.fn_type({ world.mem_type() }) }), {location, name});
+        }
+        // the last argument selects the data cache
+        auto byte_ptr = world.bitcast(byte_ptr_type, ptr, location);
+        cur_bb = call(prefetch_, { cur_mem, byte_ptr, world.literal_qs32(rw, location), world.literal_qs32(locality, location), world.literal_qs32(1, location) },
+                      world.tuple_type({}), {location, "prefetch"}).first;
+        cur_mem = cur_bb->param(0);
+    }
+
+    /**
+     * Declaration of the function of type @p fn_type which stands in for what Thorin cannot express, like non-temporal or masked memory accesses.
+     * Its name starts with @p prefix - one of those in @p BackendHints - by which the driver replaces its calls.
+     */
+    Continuation* stand_in(const char* prefix, const thorin::Type* fn_type, Location location) {
+        auto& continuation = stand_ins_[std::make_pair(std::string(prefix), fn_type)];
+        if (!continuation)
+            continuation = world.continuation(fn_type->as<thorin::FnType>(), {location, prefix + std::to_string(stand_ins_.size())});
+        return continuation;
+    }
+
+    /// Lane @c i of the result is lane @c lanes[i] of the concatenation of the vectors @p a and @p b with @p dim lanes each.
+    const Def* shuffle(const Def* a, const Def* b, uint64_t dim, ArrayRef<uint64_t> lanes, Location location) {
+        Array<const Def*> elems(lanes.size());
+        for (size_t i = 0, e = lanes.size(); i != e; ++i)
+            elems[i] = lanes[i] < dim ? world.extract(a, lanes[i], location) : world.extract(b, lanes[i] - dim, location);
+        // LLVM turns this into a shufflevector
+        return elems.size() == 1 ? elems.front() : world.vector(elems, location);
+    }
+
+    /**
+     * Combines the @p dim lanes of the vector @p v with @p op by halving the vector until one lane is left.
+     * LLVM turns the halves into shuffles, thus this takes log2(dim) vector ops - it rounds differently than folding the lanes in order though.
+     */
+    template<class Op>
+    const Def* reduce(const Def* v, uint64_t dim, Op op, Location location) {
+        for (auto n = dim; n > 1; n /= 2) {
+            auto half = n / 2;
+            Array<uint64_t> lo(half), hi(half);
+            for (size_t i = 0; i != half; ++i) {
+                lo[i] = i;
+                hi[i] = half + i;
+            }
+            auto rest = n % 2 != 0 ? world.extract(v, n - 1, location) : nullptr;
+            v = op(shuffle(v, v, n, lo, location), shuffle(v, v, n, hi, location));
+            if (rest) {
+                if (half == 1)
+                    v = op(v, rest);
+                else
+                    v = world.insert(v, world.literal_qu32(0, location), op(world.extract(v, 0_s, location), rest), location);
+            }
+        }
+        return v;
+    }
+
+    /**
+     * Zero-sized type whose alignment is @p align: an empty array of vectors of @p align bytes, which LLVM aligns to their size.
+     * As the last field of a struct it aligns the struct and pads its size like @c alignas on its first field does in C.
+     */
+    const thorin::Type* align_type(uint32_t align) { return world.definite_array_type(world.type(PrimType_pu8, align), 0); }
+
+    /// Requests @p align for the global or slot @p def - Thorin cannot align them itself, so the backend does.
+    void align(const Def* def, uint32_t align) {
+        if (align != 0)
+            aligns_[def_key(def)] = align;
+    }
+
+    /// The hints of all functions and the alignments of globals and slots.
+    BackendHints backend_hints() {
+        BackendHints hints;
+        hints.def_fns = fn_hints_;
+        hints.def_aligns = aligns_;
+        hints.has_stand_ins = !stand_ins_.empty();
+        return hints;
+    }
+
     const thorin::Type*& thorin_type(const Type* type) { return impala2thorin_[type]; }
     const thorin::StructType*& thorin_struct_type(const StructType* type) { return struct_type_impala2thorin_[type]; }
     const thorin::StructType*& thorin_enum_type(const EnumType* type) { return enum_type_impala2thorin_[type]; }
 
     World& world;
+    bool branchless;
+    bool mono;
+    /// Thorin types of all type params in scope while emitting an instance; @c Var(i) denotes @c type_args[i-1].
+    std::vector<const thorin::Type*> type_args;
     const Fn* cur_fn = nullptr;
+    /// Alignment requested for the mutable locals of the let statement whose pattern is emitted right now.
+    uint32_t let_align = 0;
     TypeMap<const thorin::Type*> impala2thorin_;
     GIDMap<const StructType*, const thorin::StructType*> struct_type_impala2thorin_;
     GIDMap<const EnumType*,   const thorin::StructType*> enum_type_impala2thorin_;
     Continuation* cur_bb = nullptr;
     const Def* cur_mem = nullptr;
+
+private:
+    struct Block {
+        Continuation* parent = nullptr;     ///< unique predecessor if this is no join
+        std::vector<size_t> preds;          ///< indices into @p jumps_ if this is a join
+        std::vector<std::pair<const Def*, const thorin::Param*>> incomplete_phis;
+        DefMap<const Def*> values;
+        bool is_join = false;
+        bool sealed = true;
+        bool unreachable = false;
+    };
+
+    struct Instance {
+        const FnDecl* fn_decl;
+        std::vector<const thorin::Type*> type_args;
+        Continuation* continuation;
+    };
+
+    struct Jump {
+        Continuation* from;
+        Continuation* to;
+        std::vector<const Def*> args;
+        Debug dbg;
+    };
+
+    Block* block(Continuation* bb) {
+        auto& b = blocks_[bb];
+        if (!b) b = std::make_unique<Block>();
+        return b.get();
+    }
+
+    const thorin::Param* phi(Continuation* bb, const Def* var) {
+        auto param = bb->append_param(var->type()->as<thorin::PtrType>()->pointee(), var->debug());
+        phis_.emplace_back(bb, param);
+        return param;
+    }
+
+    void add_phi_operands(Block* b, const Def* var, const thorin::Param* phi) {
+        for (auto j : b->preds) {
+            auto arg = read(jumps_[j].from, var);
+            auto& args = jumps_[j].args;
+            if (args.size() <= phi->index())
+                args.resize(phi->index() + 1);
+            args[phi->index()] = arg;
+        }
+    }
+
+    const Def* resolve(const Def* def) {
+        for (auto i = forward_.find(def); i != forward_.end(); i = forward_.find(def))
+            def = i->second;
+        return def;
+    }
+
+    std::unordered_map<std::string, const Def*> strings_;
+    DefMap<const Def*> const_globals_;
+    DefSet ssa_vars_;
+    DefMap<std::pair<const Def*, const Def*>> ssa_elems_; ///< handles of elements of @p ssa_vars_ - aggregate and index
+    ContinuationMap<std::unique_ptr<Block>> blocks_;
+    std::vector<Jump> jumps_;
+    std::vector<std::pair<Continuation*, const thorin::Param*>> phis_;
+    DefMap<const Def*> forward_;
+    std::map<std::pair<const FnDecl*, const thorin::Type*>, Continuation*> instance_map_; ///< keyed by the tuple of all type args
+    std::map<std::pair<const Type*, const thorin::Type*>, const thorin::Type*> instance_types_; ///< keyed by the tuple of all type args
+    std::deque<Instance> instances_;                                                      ///< instances whose body is pending
+    Continuation* expect_ = nullptr;                                                      ///< declaration of @c llvm.expect.i1
+    Continuation* prefetch_ = nullptr;                                                    ///< declaration of @c llvm.prefetch
+    std::map<std::pair<std::string, const thorin::Type*>, Continuation*> stand_ins_;     ///< keyed by their prefix and type
+    std::map<std::string, FnHints> fn_hints_;                                             ///< keyed by @p def_key
+    std::map<std::string, uint32_t> aligns_;                                              ///< keyed by @p def_key
 };
 
+void CodeGen::seal(Continuation* bb) {
+    auto b = block(bb);
+    assert(b->is_join && !b->sealed);
+    // reading in predecessors may add further incomplete phis to bb
+    for (size_t i = 0; i != b->incomplete_phis.size(); ++i)
+        add_phi_operands(b, b->incomplete_phis[i].first, b->incomplete_phis[i].second);
+    b->incomplete_phis.clear();
+    b->sealed = true;
+}
+
+const Def* CodeGen::read(Continuation* bb, const Def* var) {
+    auto b = block(bb);
+    auto i = b->values.find(var);
+    if (i != b->values.end())
+        return i->second;
+
+    const Def* val;
+    if (!b->is_join) {
+        val = b->parent ? read(b->parent, var) : world.bottom(var->type()->as<thorin::PtrType>()->pointee(), var->debug());
+    } else if (!b->sealed) {
+        auto param = phi(bb, var);
+        b->incomplete_phis.emplace_back(var, param);
+        val = param;
+    } else if (b->preds.size() == 1) {
+        val = read(jumps_[b->preds.front()].from, var);
+    } else {
+        auto param = phi(bb, var);
+        b->values[var] = param; // break cycles
+        add_phi_operands(b, var, param);
+        return param;
+    }
+
+    return b->values[var] = val;
+}
+
+void CodeGen::finalize() {
+    std::vector<Continuation*> unsealed;
+    for (auto&& p : blocks_) {
+        if (p.second->is_join && !p.second->sealed)
+            unsealed.push_back(p.first);
+    }
+    for (auto bb : unsealed)
+        seal(bb);
+
+    // a phi is trivial if it merges only one value besides itself
+    for (bool todo = true; todo;) {
+        todo = false;
+        for (auto&& p : phis_) {
+            auto bb = p.first;
+            auto phi = p.second;
+            if (forward_.contains(phi)) continue;
+
+            const Def* same = nullptr;
+            bool trivial = true;
+            for (auto j : block(bb)->preds) {
+                auto arg = resolve(jumps_[j].args[phi->index()]);
+                if (arg == phi || arg == same) continue;
+                if (same != nullptr) {
+                    trivial = false;
+                    break;
+                }
+                same = arg;
+            }
+
+            if (trivial) {
+                forward_[phi] = same ? same : world.bottom(phi->type(), phi->debug());
+                todo = true;
+            }
+        }
+    }
+
+    for (auto&& jump : jumps_) {
+        assert(jump.args.size() == jump.to->num_params());
+        for (auto& arg : jump.args)
+            arg = resolve(arg);
+        jump.from->jump(jump.to, jump.args, jump.dbg);
+    }
+
+    for (auto&& p : phis_) {
+        if (forward_.contains(p.second))
+            p.second->replace(resolve(p.second));
+    }
+}
+
 /*
  * Type
  */
@@ -136,6 +541,10 @@ const thorin::Type* CodeGen::convert_rec(const Type* type) {
     if (auto lambda = type->isa<Lambda>()) {
         return world.lambda(convert(lambda->body()), lambda->name());
     } else if (auto var = type->isa<Var>()) {
+        if (mono) {
+            assert(var->depth() >= 1 && size_t(var->depth()) <= type_args.size());
+            return type_args[var->depth() - 1];
+        }
         return world.var(var->depth());
     } else if (auto prim_type = type->isa<PrimType>()) {
         switch (prim_type->primtype_tag()) {
@@ -156,18 +565,21 @@ const thorin::Type* CodeGen::convert_rec(const Type* type) {
             nops.push_back(convert(op));
         return world.tuple_type(nops);
     } else if (auto struct_type = type->isa<StructType>()) {
-        auto s = world.struct_type(struct_type->struct_decl()->symbol(), struct_type->num_ops());
+        auto align = struct_type->struct_decl()->align();
+        auto s = world.struct_type(struct_type->struct_decl()->symbol(), struct_type->num_ops() + (align > 1 ? 1 : 0));
         thorin_struct_type(struct_type) = s;
-        thorin_type(type) = s;
+        cached_type(type) = s;
         size_t i = 0;
         for (auto&& op : struct_type->ops())
             s->set(i++, convert(op));
-        thorin_type(type) = nullptr; // will be set again by CodeGen's wrapper
+        if (align > 1)
+            s->set(i, align_type(align));
+        cached_type(type) = nullptr; // will be set again by CodeGen's wrapper
         return s;
     } else if (auto enum_type = type->isa<EnumType>()) {
         auto s = world.struct_type(enum_type->enum_decl()->symbol(), 2);
         thorin_enum_type(enum_type) = s;
-        thorin_type(enum_type) = s;
+        cached_type(enum_type) = s;
 
         auto enum_decl = enum_type->enum_decl();
         thorin::TypeSet variants;
@@ -178,7 +590,7 @@ const thorin::Type* CodeGen::convert_rec(const Type* type) {
 
         s->set(0, world.type_qu32());
         s->set(1, world.variant_type(ops));
-        thorin_type(enum_type) = nullptr;
+        cached_type(enum_type) = nullptr;
         return s;
     } else if (auto ptr_type = type->isa<PtrType>()) {
         return world.ptr_type(convert(ptr_type->pointee()), 1, -1, thorin::AddrSpace(ptr_type->addr_space()));
@@ -194,24 +606,61 @@ const thorin::Type* CodeGen::convert_rec(const Type* type) {
     THORIN_UNREACHABLE;
 }
 
+Continuation* CodeGen::instantiate(const FnDecl* fn_decl, ArrayRef<const thorin::Type*> args) {
+    // type params of enclosing generic functions are still in scope
+    size_t num_outer = fn_decl->ast_type_param(0)->lambda_depth() - 1;
+    assert(num_outer <= type_args.size());
+    std::vector<const thorin::Type*> all_args(type_args.begin(), type_args.begin() + num_outer);
+    all_args.insert(all_args.end(), args.begin(), args.end());
+
+    auto& continuation = instance_map_[std::make_pair(fn_decl, world.tuple_type(all_args))];
+    if (continuation == nullptr) {
+        THORIN_PUSH(type_args, all_args);
+        continuation = fn_decl->fn_emit_head(*this, fn_decl->location());
+        instances_.push_back({fn_decl, all_args, continuation});
+    }
+    return continuation;
+}
+
+void CodeGen::emit_instances() {
+    // bodies are emitted one after another as the AST caches the defs of the current instance
+    while (!instances_.empty()) {
+        auto instance = instances_.front();
+        instances_.pop_front();
+        THORIN_PUSH(type_args, instance.type_args);
+        instance.fn_decl->emit_instance(*this, instance.continuation);
+    }
+}
+
 /*
  * Decls and Function
  */
 
 void LocalDecl::emit(CodeGen& cg, const Def* init) const {
-    assert(def_ == nullptr);
+    assert(def_ == nullptr || !cg.type_args.empty()); // locals of generic functions are emitted once per instance
 
     auto thorin_type = cg.convert(type());
     init = init ? init : cg.world.bottom(thorin_type);
 
     if (is_mut()) {
         def_ = cg.world.slot(thorin_type, cg.frame(), debug());
-        cg.cur_mem = cg.world.store(cg.cur_mem, def_, init, debug());
+        // the slot is merely a handle if the local never needs to live in memory
+        if (!is_address_taken_ && !fn()->has_escaping_continuation())
+            cg.promote(def_);
+        else
+            cg.align(def_, cg.let_align);
+        cg.store(def_, init, location());
     } else {
         def_ = init;
     }
 }
 
+void LocalDecl::emit_slot(CodeGen& cg, const Def* slot) const {
+    def_ = slot;
+    is_in_slot_ = true;
+    cg.align(def_, cg.let_align);
+}
+
 const thorin::Type* OptionDecl::variant_type(CodeGen& cg) const {
     std::vector<const thorin::Type*> types;
     for (auto&& arg : args())
@@ -222,7 +671,27 @@ const thorin::Type* OptionDecl::variant_type(CodeGen& cg) const {
 
 Continuation* Fn::fn_emit_head(CodeGen& cg, Location location) const {
     auto t = cg.convert(fn_type())->as<thorin::FnType>();
-    return continuation_ = cg.world.continuation(t, {location, fn_symbol().remove_quotation()});
+    continuation_ = cg.world.continuation(t, {location, fn_symbol().remove_quotation()});
+    cg.fn_hints(continuation_, fn_hints());
+    return continuation_;
+}
+
+FnHints Fn::fn_hints() const {
+    FnHints hints;
+    hints.attributes = attributes();
+    // Thorin's LLVM backend drops mem and continuation params - the others become the params of the LLVM function
+    bool restricted = false;
+    for (size_t i = 0, e = fn_type()->num_params(); i != e; ++i) {
+        auto param = fn_type()->param(i);
+        if (param->isa<FnType>())
+            continue;
+        auto ptr_type = param->isa<BorrowedPtrType>();
+        hints.noalias.push_back(ptr_type && ptr_type->is_restrict());
+        restricted |= hints.noalias.back();
+    }
+    if (!restricted)
+        hints.noalias.clear();
+    return hints;
 }
 
 void Fn::fn_emit_body(CodeGen& cg, Location location) const {
@@ -299,21 +768,35 @@ void Fn::fn_emit_body(CodeGen& cg, Location location) const {
  */
 
 void Module::emit(CodeGen& cg) const {
-    for (auto&& item : items()) item->emit_head(cg);
-    for (auto&& item : items()) item->emit(cg);
+    for (auto&& item : items()) if (!item->is_dead()) item->emit_head(cg);
+    for (auto&& item : items()) if (!item->is_dead()) item->emit(cg);
 }
 
 static bool is_primop(const Symbol& name) {
     if      (name == "alignof") return true;
     else if (name == "bitcast") return true;
     else if (name == "insert")  return true;
+    else if (name == "gather")  return true;
+    else if (name == "likely")  return true;
+    else if (name == "masked_load") return true;
+    else if (name == "masked_store") return true;
+    else if (name == "nontemporal_store") return true;
+    else if (name == "prefetch") return true;
+    else if (name == "reduce_add") return true;
+    else if (name == "reduce_min") return true;
     else if (name == "select")  return true;
+    else if (name == "shuffle") return true;
     else if (name == "sizeof")  return true;
+    else if (name == "unlikely") return true;
     return false;
 }
 
 void FnDecl::emit_head(CodeGen& cg) const {
-    assert(def_ == nullptr);
+    assert(def_ == nullptr || !cg.type_args.empty());
+    // generic functions are instantiated on demand
+    if (cg.mono && num_ast_type_params() != 0)
+        return;
+
     // no code is emitted for primops
     if (is_extern() && abi() == "\"thorin\"" && is_primop(symbol()))
         return;
@@ -329,10 +812,15 @@ void FnDecl::emit_head(CodeGen& cg) const {
 }
 
 void FnDecl::emit(CodeGen& cg) const {
-    if (body())
+    if (body() && continuation())
         fn_emit_body(cg, location());
 }
 
+void FnDecl::emit_instance(CodeGen& cg, Continuation* continuation) const {
+    continuation_ = continuation;
+    fn_emit_body(cg, location());
+}
+
 void ExternBlock::emit_head(CodeGen& cg) const {
     for (auto&& fn_decl : fn_decls()) {
         fn_decl->emit_head(cg);
@@ -349,20 +837,42 @@ void ExternBlock::emit_head(CodeGen& cg) const {
 void ModuleDecl::emit(CodeGen&) const {}
 void ImplItem::emit(CodeGen&) const {}
 
+/// Repeated arrays with more elements are filled by a loop instead of a definite_array with one op per element.
+static const uint64_t max_unrolled_splat = 64;
+
 void StaticItem::emit_head(CodeGen& cg) const {
-    def_ = cg.world.global(cg.world.bottom(cg.convert(type()), location()));
+    auto thorin_type = cg.convert(type());
+    def_ = cg.world.global(cg.world.bottom(thorin_type, location()), /*mutable*/ true, debug());
+    // the initialized global replacing this one in emit has the same location and name
+    cg.align(def_, align());
 }
 
 void StaticItem::emit(CodeGen& cg) const {
+    // PathExpr emits statics on demand, so initializers are emitted in dependency order
+    if (is_emitted_) return;
+    is_emitted_ = true;
+
     if (init()) {
+        // initializers are evaluated at compile time - never in the context of the user
+        THORIN_PUSH(cg.cur_fn, nullptr);
+        THORIN_PUSH(cg.cur_bb, nullptr);
+        THORIN_PUSH(cg.cur_mem, nullptr);
         auto old_def = def_;
-        def_ = cg.world.global(init()->remit(cg), is_mut(), debug());
+        auto repeated = init()->isa<RepeatedDefiniteArrayExpr>();
+        if (repeated && repeated->count() > max_unrolled_splat && repeated->is_zero(cg)) {
+            // no definite_array with one op per element - mutable so that loads are not folded to bottom
+            def_ = cg.world.global(cg.world.bottom(cg.convert(type()), location()), /*mutable*/ true, debug());
+        } else {
+            def_ = cg.world.global(init()->remit(cg), is_mut(), debug());
+        }
         old_def->replace(def_);
     }
 }
 
 void StructDecl::emit_head(CodeGen& cg) const {
-    cg.convert(type());
+    // under monomorphization only instances of a generic struct are converted - on use
+    if (!cg.mono || num_ast_type_params() == 0)
+        cg.convert(type());
 }
 
 void OptionDecl::emit(CodeGen& cg) const {
@@ -422,11 +932,7 @@ const Def* CharExpr::remit(CodeGen& cg) const {
 }
 
 const Def* StrExpr::remit(CodeGen& cg) const {
-    Array<const Def*> args(values_.size());
-    for (size_t i = 0, e = args.size(); i != e; ++i)
-        args[i] = cg.world.literal_pu8(values_[i], location());
-
-    return cg.world.definite_array(args, location());
+    return cg.string(values(), location());
 }
 
 const Def* CastExpr::remit(CodeGen& cg) const {
@@ -446,26 +952,46 @@ const Def* RValueExpr::remit(CodeGen& cg) const {
     return src()->remit(cg);
 }
 
-const Def* PathExpr::lemit(CodeGen&) const {
-    assert(value_decl()->is_mut());
+/// Whether @p expr is an array kept in memory instead of a value with one op per element - indexing it loads the element only.
+static bool in_slot(CodeGen& cg, const Expr* expr) {
+    if (auto path = expr->isa<PathExpr>()) {
+        if (auto static_item = path->value_decl()->isa<StaticItem>()) {
+            // a large zero splat is kept as a zero-initialized global, see StaticItem::emit
+            static_item->emit(cg);
+            return cg.cur_mem != nullptr && static_item->init() && static_item->def()->as<Global>()->init()->isa<Bottom>();
+        }
+        auto local = path->value_decl()->isa<LocalDecl>();
+        return local && local->is_in_slot();
+    }
+    if (auto repeated = expr->isa<RepeatedDefiniteArrayExpr>())
+        return repeated->count() > max_unrolled_splat && cg.cur_fn != nullptr;
+    return false;
+}
+
+const Def* PathExpr::lemit(CodeGen& cg) const {
+    assert(value_decl()->is_mut() || value_decl()->isa<StaticItem>() || in_slot(cg, this));
+    if (auto static_item = value_decl()->isa<StaticItem>())
+        static_item->emit(cg);
     return value_decl()->def();
 }
 
 const Def* PathExpr::remit(CodeGen& cg) const {
+    if (auto static_item = value_decl()->isa<StaticItem>()) {
+        static_item->emit(cg);
+        auto global = static_item->def()->as<Global>();
+        // immutable statics are folded into their users, initializers of other statics always do so as they have no memory -
+        // TypeSema rejects cycles and reads of mutable statics there
+        if (!static_item->is_mut() && ((is_const(global->init()) && !global->init()->isa<Bottom>()) || cg.cur_mem == nullptr)) {
+            // a large zero splat is kept as a zero-initialized global - build it here if another initializer needs its value
+            if (global->init()->isa<Bottom>() && static_item->init())
+                return static_item->init()->remit(cg);
+            return global->init();
+        }
+        return cg.load(global, location());
+    }
+
     auto def = value_decl()->def();
-    // This whole global thing is incorrect.
-    // Example:
-    // static a = 1;
-    // static b = a;
-    // Emitting this requires a load. Currently, it works because of the following hack.
-    // But the hack no longer works if the order is reversed:
-    // static b = a;
-    // static a = 1;
-    // In this case, during the emission of 'static b = a', the static item 'a' has not been replaced yet and is considered mutable.
-    auto global = def->isa<Global>();
-    if (global && !global->is_mutable())
-        return global->init();
-    return value_decl()->is_mut() || global ? cg.load(def, location()) : def;
+    return value_decl()->is_mut() || in_slot(cg, this) ? cg.load(def, location()) : def;
 }
 
 const Def* PrefixExpr::remit(CodeGen& cg) const {
@@ -489,12 +1015,12 @@ const Def* PrefixExpr::remit(CodeGen& cg) const {
             return ptr;
         }
         case AND: {
-            if (rhs()->type()->isa<RefType>())
+            if (rhs()->type()->isa<RefType>() || in_slot(cg, rhs()))
                 return rhs()->lemit(cg);
 
             auto def = rhs()->remit(cg);
             if (is_const(def))
-                return cg.world.global(def, /*mutable*/ false, location());
+                return cg.const_global(def, location());
 
             auto slot = cg.world.slot(cg.convert(rhs()->type()), cg.frame(), location());
             cg.store(slot, def, location());
@@ -535,24 +1061,35 @@ void Expr::emit_branch(CodeGen& cg, Continuation* jump_true, Continuation* jump_
     auto expr_true  = cg.basicblock({ location().back(), "expr_true"  });
     auto expr_false = cg.basicblock({ location().back(), "expr_false" });
     auto cond = remit(cg);
-    cg.cur_bb->branch(cond, expr_true, expr_false, location().back());
-    expr_true->jump(jump_true, { cg.cur_mem });
-    expr_false->jump(jump_false, { cg.cur_mem });
+    cg.branch(cond, expr_true, expr_false, location().back());
+    auto mem = cg.cur_mem;
+    cg.enter(expr_true, mem);
+    cg.jump(jump_true, { mem }, location().back());
+    cg.enter(expr_false, mem);
+    cg.jump(jump_false, { mem }, location().back());
 }
 
 void InfixExpr::emit_branch(CodeGen& cg, Continuation* jump_true, Continuation* jump_false) const {
+    // a single branch on the combined condition
+    if ((tag() == OROR || tag() == ANDAND) && cg.speculate(rhs()))
+        return Expr::emit_branch(cg, jump_true, jump_false);
+
     auto jump_type = jump_true->type();
     switch (tag()) {
         case OROR: {
                 auto or_false = cg.world.continuation(jump_type, { location().back(), "or_false" });
+                cg.join(or_false);
                 lhs()->emit_branch(cg, jump_true, or_false);
+                cg.seal(or_false);
                 cg.enter(or_false, or_false->param(0));
                 rhs()->emit_branch(cg, jump_true, jump_false);
             }
             break;
         case ANDAND: {
                 auto and_true = cg.world.continuation(jump_type, { location().back(), "and_true" });
+                cg.join(and_true);
                 lhs()->emit_branch(cg, and_true, jump_false);
+                cg.seal(and_true);
                 cg.enter(and_true, and_true->param(0));
                 rhs()->emit_branch(cg, jump_true, jump_false);
             }
@@ -566,13 +1103,27 @@ const Def* InfixExpr::remit(CodeGen& cg) const {
     switch (tag()) {
         case OROR:
         case ANDAND: {
+            if (cg.speculate(rhs())) {
+                auto ldef = lhs()->remit(cg);
+                auto rdef = rhs()->remit(cg);
+                return tag() == OROR ? cg.world.arithop_or(ldef, rdef, location()) : cg.world.arithop_and(ldef, rdef, location());
+            }
+
             auto result     = cg.basicblock(cg.world.type_bool(), { location().back(), "infix_result" });
             auto jump_type  = cg.world.fn_type({ cg.world.mem_type() });
             auto jump_true  = cg.world.continuation(jump_type, { location().back(), "jump_true" });
             auto jump_false = cg.world.continuation(jump_type, { location().back(), "jump_true" });
+            cg.join(result);
+            cg.join(jump_true);
+            cg.join(jump_false);
             emit_branch(cg, jump_true, jump_false);
-            jump_true->jump(result, { jump_true->param(0), cg.world.literal(true) });
-            jump_false->jump(result, { jump_false->param(0), cg.world.literal(false) });
+            cg.seal(jump_true);
+            cg.seal(jump_false);
+            cg.enter(jump_true, jump_true->param(0));
+            cg.jump(result, { cg.cur_mem, cg.world.literal(true) }, location().back());
+            cg.enter(jump_false, jump_false->param(0));
+            cg.jump(result, { cg.cur_mem, cg.world.literal(false) }, location().back());
+            cg.seal(result);
             return cg.enter(result);
         }
         default:
@@ -612,12 +1163,56 @@ const Def* DefiniteArrayExpr::remit(CodeGen& cg) const {
     return cg.world.definite_array(cg.convert(type())->as<thorin::DefiniteArrayType>()->elem_type(), thorin_args, location());
 }
 
+const Def* RepeatedDefiniteArrayExpr::lemit(CodeGen& cg) const {
+    auto slot = emit_slot(cg, {location(), "splat"});
+    assert(slot && "only large repeated arrays within functions live in memory");
+    return slot;
+}
+
 const Def* RepeatedDefiniteArrayExpr::remit(CodeGen& cg) const {
+    // loading the filled slot as a whole is expensive - indexing and borrowing use lemit, lets keep the slot, see LetStmt::emit
+    if (in_slot(cg, this))
+        return cg.load(lemit(cg), location());
+
+    auto def = value()->remit(cg);
     Array<const Def*> args(count());
-    std::fill_n(args.begin(), count(), value()->remit(cg));
+    std::fill_n(args.begin(), count(), def);
     return cg.world.definite_array(args, location());
 }
 
+bool RepeatedDefiniteArrayExpr::is_zero(CodeGen& cg) const { return thorin::is_zero(value()->remit(cg)); }
+
+const Def* RepeatedDefiniteArrayExpr::emit_slot(CodeGen& cg, Debug dbg) const {
+    // statics need a constant initializer
+    if (count() <= max_unrolled_splat || cg.cur_fn == nullptr)
+        return nullptr;
+
+    auto def = value()->remit(cg);
+    auto slot = cg.world.slot(cg.convert(type()), cg.frame(), dbg);
+    auto index_type = cg.world.type_qs64();
+    auto head_bb = cg.world.continuation(cg.world.fn_type({cg.world.mem_type(), index_type}), {location(), "splat_head"});
+    auto body_bb = cg.basicblock({location(), "splat_body"});
+    auto exit_bb = cg.basicblock({location(), "splat_exit"});
+    head_bb->param(0)->debug().set("mem");
+    head_bb->param(1)->debug().set("i");
+
+    cg.join(head_bb);
+    cg.jump(head_bb, {cg.cur_mem, cg.world.literal_qs64(0, location())}, location());
+
+    cg.enter(head_bb, head_bb->param(0));
+    auto index = head_bb->param(1);
+    cg.branch(cg.world.cmp_lt(index, cg.world.literal_qs64(count(), location()), location()), body_bb, exit_bb, location());
+
+    auto mem = cg.cur_mem;
+    cg.enter(body_bb, mem);
+    cg.store(cg.world.lea(slot, index, location()), def, location());
+    cg.jump(head_bb, {cg.cur_mem, cg.world.arithop_add(index, cg.world.one(index_type), location())}, location());
+    cg.seal(head_bb);
+
+    cg.enter(exit_bb, mem);
+    return slot;
+}
+
 const Def* TupleExpr::remit(CodeGen& cg) const {
     Array<const Def*> thorin_args(num_args());
     for (size_t i = 0, e = num_args(); i != e; ++i)
@@ -638,18 +1233,37 @@ const Def* SimdExpr::remit(CodeGen& cg) const {
 }
 
 const Def* StructExpr::remit(CodeGen& cg) const {
-    Array<const Def*> defs(num_elems());
+    auto struct_type = cg.convert(type())->as<thorin::StructType>();
+    Array<const Def*> defs(struct_type->num_ops());
     for (auto&& elem : elems())
         defs[elem->field_decl()->index()] = elem->expr()->remit(cg);
-    return cg.world.struct_agg(cg.convert(type())->as<thorin::StructType>(), defs, location());
+    // the field aligning the struct holds nothing
+    if (defs.size() != num_elems())
+        defs.back() = cg.world.bottom(struct_type->op(num_elems()), location());
+    return cg.world.struct_agg(struct_type, defs, location());
 }
 
 const Def* TypeAppExpr::lemit(CodeGen&) const { THORIN_UNREACHABLE; }
-const Def* TypeAppExpr::remit(CodeGen& /*cg*/) const { THORIN_UNREACHABLE; }
+const Def* TypeAppExpr::remit(CodeGen& cg) const {
+    auto path = lhs()->skip_rvalue()->isa<PathExpr>();
+    auto fn_decl = path ? path->value_decl()->isa<FnDecl>() : nullptr;
+    if (!cg.mono || fn_decl == nullptr || fn_decl->body() == nullptr)
+        THORIN_UNREACHABLE;
+
+    Array<const thorin::Type*> args(num_type_args());
+    for (size_t i = 0, e = num_type_args(); i != e; ++i)
+        args[i] = cg.convert(type_arg(i));
+    return cg.instantiate(fn_decl, args);
+}
+
+static bool is_static(const Expr* expr) {
+    auto path = expr->isa<PathExpr>();
+    return path && path->value_decl()->isa<StaticItem>();
+}
 
 const Def* MapExpr::lemit(CodeGen& cg) const {
     auto agg = lhs()->lemit(cg);
-    return cg.world.lea(agg, arg(0)->remit(cg), location());
+    return cg.lea(agg, arg(0)->remit(cg), location());
 }
 
 const Def* MapExpr::remit(CodeGen& cg) const {
@@ -658,6 +1272,15 @@ const Def* MapExpr::remit(CodeGen& cg) const {
     if (auto fn_type = ltype->isa<FnType>()) {
         const Def* dst = nullptr;
 
+        // likely and unlikely are the only primops which are not polymorphic
+        if (auto path = lhs()->skip_rvalue()->isa<PathExpr>()) {
+            if (auto fn_decl = path->value_decl()->isa<FnDecl>()) {
+                auto name = fn_decl->fn_symbol().remove_quotation();
+                if (fn_decl->is_extern() && fn_decl->abi() == "\"thorin\"" && (name == "likely" || name == "unlikely"))
+                    return cg.expect(arg(0)->remit(cg), name == "likely", location());
+            }
+        }
+
         // Handle primops here
         if (auto type_expr = lhs()->isa<TypeAppExpr>()) { // alignof, bitcast, sizeof, and select are all polymorphic
             auto callee = type_expr->lhs()->skip_rvalue();
@@ -678,6 +1301,42 @@ const Def* MapExpr::remit(CodeGen& cg) const {
                             return cg.world.size_of(cg.convert(type_expr->type_arg(0)), location());
                         } else if (name == "undef") {
                             return cg.world.bottom(cg.convert(type_expr->type_arg(0)), location());
+                        } else if (name == "prefetch") {
+                            // LLVM only accepts constants here
+                            auto constant = [&] (size_t i, uint64_t max, const char* what) {
+                                auto literal = arg(i)->isa<LiteralExpr>();
+                                if (literal && literal->get_u64() <= max)
+                                    return int(literal->get_u64());
+                                error(arg(i), "{} of prefetch must be a literal between 0 and {}", what, max);
+                                return 0;
+                            };
+                            auto rw = constant(1, 1, "read/write flag");
+                            auto locality = constant(2, 3, "locality");
+                            cg.prefetch(arg(0)->remit(cg), rw, locality, location());
+                            return cg.world.tuple({}, location());
+                        } else if (name == "nontemporal_store") {
+                            dst = cg.stand_in(BackendHints::nontemporal_store_prefix(), cg.convert(lhs()->type()), location());
+                        } else if (name == "masked_load") {
+                            dst = cg.stand_in(BackendHints::masked_load_prefix(), cg.convert(lhs()->type()), location());
+                        } else if (name == "masked_store") {
+                            dst = cg.stand_in(BackendHints::masked_store_prefix(), cg.convert(lhs()->type()), location());
+                        } else if (name == "gather") {
+                            dst = cg.stand_in(BackendHints::gather_prefix(), cg.convert(lhs()->type()), location());
+                        } else if (name == "shuffle") {
+                            // TypeSema made sure that the mask is a simd expression of literals
+                            auto mask = arg(2)->as<SimdExpr>();
+                            Array<uint64_t> lanes(mask->num_args());
+                            for (size_t i = 0, e = lanes.size(); i != e; ++i)
+                                lanes[i] = mask->arg(i)->as<LiteralExpr>()->get_u64();
+                            auto dim = unpack_ref_type(arg(0)->type())->as<SimdType>()->dim();
+                            return cg.shuffle(arg(0)->remit(cg), arg(1)->remit(cg), dim, lanes, location());
+                        } else if (name == "reduce_add" || name == "reduce_min") {
+                            auto dim = unpack_ref_type(arg(0)->type())->as<SimdType>()->dim();
+                            auto add = [&] (const Def* a, const Def* b) { return cg.world.arithop_add(a, b, location()); };
+                            auto minimum = [&] (const Def* a, const Def* b) { return cg.world.select(cg.world.cmp_lt(a, b, location()), a, b, location()); };
+                            if (name == "reduce_add")
+                                return cg.reduce(arg(0)->remit(cg), dim, add, location());
+                            return cg.reduce(arg(0)->remit(cg), dim, minimum, location());
                         } else if (name == "reserve_shared") {
                             auto ptr_type = cg.convert(type());
                             auto fn_type = cg.world.fn_type({
@@ -763,6 +1422,9 @@ const Def* MapExpr::remit(CodeGen& cg) const {
 
         return ret;
     } else if (ltype->isa<ArrayType>() || ltype->isa<TupleType>() || ltype->isa<SimdType>()) {
+        // load only the element if the aggregate lives in memory - constant indices into statics are folded below
+        if (lhs()->type()->isa<RefType>() || in_slot(cg, lhs()) || (is_static(lhs()) && !arg(0)->isa<LiteralExpr>()))
+            return cg.load(lemit(cg), location());
         auto index = arg(0)->remit(cg);
         return cg.world.extract(lhs()->remit(cg), index, location());
     }
@@ -771,10 +1433,12 @@ const Def* MapExpr::remit(CodeGen& cg) const {
 
 const Def* FieldExpr::lemit(CodeGen& cg) const {
     auto value = lhs()->lemit(cg);
-    return cg.world.lea(value, cg.world.literal_qu32(index(), location()), location());
+    return cg.lea(value, cg.world.literal_qu32(index(), location()), location());
 }
 
 const Def* FieldExpr::remit(CodeGen& cg) const {
+    if (lhs()->type()->isa<RefType>())
+        return cg.load(lemit(cg), location());
     return cg.world.extract(lhs()->remit(cg), index(), location());
 }
 
@@ -792,107 +1456,310 @@ const Def* BlockExpr::remit(CodeGen& cg) const {
 const Def* IfExpr::remit(CodeGen& cg) const {
     auto thorin_type = cg.convert(type());
 
+    if (thorin_type && cg.speculate(then_expr()) && cg.speculate(else_expr())) {
+        auto cond = this->cond()->remit(cg);
+        auto tdef = then_expr()->remit(cg);
+        auto fdef = else_expr()->remit(cg);
+        return cg.world.select(cond, tdef, fdef, location());
+    }
+
     auto jump_type = cg.world.fn_type({ cg.world.mem_type() });
     auto if_then = cg.world.continuation(jump_type, {then_expr()->location().front(), "if_then"});
     auto if_else = cg.world.continuation(jump_type, {else_expr()->location().front(), "if_else"});
     auto if_join = thorin_type ? cg.basicblock(thorin_type, {location().back(), "if_join"}) : nullptr; // TODO rewrite with bottom type
 
+    cg.join(if_then);
+    cg.join(if_else);
+    if (if_join) cg.join(if_join);
+
     cond()->emit_branch(cg, if_then, if_else);
+    cg.seal(if_then);
+    cg.seal(if_else);
 
     cg.enter(if_then, if_then->param(0));
     if (auto tdef = then_expr()->remit(cg))
-        cg.cur_bb->jump(if_join, {cg.cur_mem, tdef}, location().back());
+        cg.jump(if_join, {cg.cur_mem, tdef}, location().back());
 
     cg.enter(if_else, if_else->param(0));
     if (auto fdef = else_expr()->remit(cg))
-        cg.cur_bb->jump(if_join, {cg.cur_mem, fdef}, location().back());
+        cg.jump(if_join, {cg.cur_mem, fdef}, location().back());
 
-    if (thorin_type)
+    if (thorin_type) {
+        cg.seal(if_join);
         return cg.enter(if_join);
+    }
     return nullptr; // TODO use bottom type
 }
 
-const Def* MatchExpr::remit(CodeGen& cg) const {
-    auto thorin_type = cg.convert(type());
+/*
+ * MatchExpr - compiled to a decision tree, see Maranget: Compiling Pattern Matching to Good Decision Trees
+ */
 
-    auto join = thorin_type ? cg.basicblock(thorin_type, {location().back(), "match_join"}) : nullptr; // TODO rewrite with bottom type
+class DecisionTree {
+public:
+    /// A row of the pattern matrix; @c nullptr is a wildcard.
+    struct Row {
+        std::vector<const Ptrn*> ptrns;
+        size_t arm;
+    };
+
+    typedef std::vector<Row> Rows;
+
+    DecisionTree(CodeGen& cg, const MatchExpr* match)
+        : cg(cg)
+        , match(match)
+        , arm_bbs(match->num_arms(), nullptr)
+    {}
 
-    auto matcher = expr()->remit(cg);
-    auto enum_type = expr()->type()->isa<EnumType>();
-    bool is_integer = is_int(expr()->type());
-    bool is_simple = enum_type && enum_type->enum_decl()->is_simple();
+    /// Emits tests for the matrix @p rows whose columns are the values @p occs.
+    void emit(const Rows& rows, const std::vector<const Def*>& occs);
+    /// Entry of the arm @p i or @c nullptr if no path in the tree leads to it.
+    Continuation* arm_bb(size_t i) const { return arm_bbs[i]; }
 
-    if (is_integer || is_simple) {
-        // integers: match continuation
-        Continuation* otherwise = nullptr;
-        size_t num_targets = num_arms();
-        Array<const Def*> defs(num_targets);
-        Array<Continuation*> targets(num_targets);
-
-        for (size_t i = 0, e = num_targets; i != e; ++i) {
-            // last pattern will always be taken
-            if (!arm(i)->ptrn()->is_refutable() || i == e - 1) {
-                num_targets = i;
-                arm(i)->ptrn()->emit(cg, matcher);
-                otherwise = cg.basicblock({arm(i)->location().front(), "otherwise"});
-                break;
-            } else {
-                if (is_integer) {
-                    defs[i] = arm(i)->ptrn()->emit(cg);
-                } else {
-                    auto enum_ptrn = arm(i)->ptrn()->as<EnumPtrn>();
-                    auto option_decl = enum_ptrn->path()->decl()->as<OptionDecl>();
-                    defs[i] = cg.world.literal_qu32(option_decl->index(), arm(i)->ptrn()->location());
-                }
-                targets[i] = cg.basicblock({arm(i)->location().front(), "case"});
+private:
+    static bool is_wildcard(const Ptrn* ptrn) { return ptrn == nullptr || !ptrn->is_refutable(); }
+
+    /// Replaces column @p col of @p row by @p ptrns.
+    static Row expand(const Row& row, size_t col, ArrayRef<const Ptrn*> ptrns) {
+        Row result{std::vector<const Ptrn*>(row.ptrns.begin(), row.ptrns.begin() + col), row.arm};
+        result.ptrns.insert(result.ptrns.end(), ptrns.begin(), ptrns.end());
+        result.ptrns.insert(result.ptrns.end(), row.ptrns.begin() + col + 1, row.ptrns.end());
+        return result;
+    }
+
+    static std::vector<const Def*> expand(const std::vector<const Def*>& occs, size_t col, ArrayRef<const Def*> defs) {
+        std::vector<const Def*> result(occs.begin(), occs.begin() + col);
+        result.insert(result.end(), defs.begin(), defs.end());
+        result.insert(result.end(), occs.begin() + col + 1, occs.end());
+        return result;
+    }
+
+    void emit_tuple(const Rows&, const std::vector<const Def*>&, size_t col, const TuplePtrn*);
+    void emit_enum(const Rows&, const std::vector<const Def*>&, size_t col, const EnumPtrn*);
+    void emit_literal(const Rows&, const std::vector<const Def*>&, size_t col, const Ptrn*);
+    void emit_leaf(size_t arm);
+
+    CodeGen& cg;
+    const MatchExpr* match;
+    Array<Continuation*> arm_bbs;
+};
+
+void DecisionTree::emit(const Rows& rows, const std::vector<const Def*>& occs) {
+    // no arm matches - e.g. behind literal arms that cover all values like true and false - so fall back to the last arm as before
+    if (rows.empty())
+        return emit_leaf(match->num_arms() - 1);
+
+    // test the first column that is refutable in the first row
+    auto& first = rows.front();
+    size_t col = 0;
+    while (col != first.ptrns.size() && is_wildcard(first.ptrns[col]))
+        ++col;
+
+    if (col == first.ptrns.size())
+        return emit_leaf(first.arm);
+
+    auto ptrn = first.ptrns[col];
+    if (auto tuple_ptrn = ptrn->isa<TuplePtrn>())
+        emit_tuple(rows, occs, col, tuple_ptrn);
+    else if (auto enum_ptrn = ptrn->isa<EnumPtrn>())
+        emit_enum(rows, occs, col, enum_ptrn);
+    else
+        emit_literal(rows, occs, col, ptrn);
+}
+
+void DecisionTree::emit_tuple(const Rows& rows, const std::vector<const Def*>& occs, size_t col, const TuplePtrn* tuple_ptrn) {
+    auto num = tuple_ptrn->num_elems();
+    Array<const Def*> elems(num);
+    for (size_t i = 0; i != num; ++i)
+        elems[i] = cg.world.extract(occs[col], i, tuple_ptrn->location());
+
+    Rows result;
+    for (auto&& row : rows) {
+        Array<const Ptrn*> ptrns(num, nullptr);
+        if (auto tuple = row.ptrns[col] ? row.ptrns[col]->isa<TuplePtrn>() : nullptr) {
+            for (size_t i = 0; i != num; ++i)
+                ptrns[i] = tuple->elem(i);
+        }
+        result.push_back(expand(row, col, ptrns));
+    }
+
+    emit(result, expand(occs, col, elems));
+}
+
+void DecisionTree::emit_enum(const Rows& rows, const std::vector<const Def*>& occs, size_t col, const EnumPtrn* enum_ptrn) {
+    auto occ = occs[col];
+    auto enum_decl = enum_ptrn->type()->as<EnumType>()->enum_decl();
+
+    // options in order of their first appearance
+    std::vector<const OptionDecl*> options;
+    Array<bool> seen(enum_decl->num_option_decls(), false);
+    for (auto&& row : rows) {
+        if (auto ptrn = row.ptrns[col] ? row.ptrns[col]->isa<EnumPtrn>() : nullptr) {
+            auto option_decl = ptrn->path()->decl()->as<OptionDecl>();
+            if (!seen[option_decl->index()]) {
+                seen[option_decl->index()] = true;
+                options.push_back(option_decl);
             }
         }
+    }
 
-        targets.shrink(num_targets);
-        defs.shrink(num_targets);
+    // if all options are listed the last one needs no test
+    bool complete = options.size() == enum_decl->num_option_decls();
+    size_t num_targets = complete ? options.size() - 1 : options.size();
+    Array<const Def*> defs(num_targets);
+    Array<Continuation*> targets(num_targets);
+    for (size_t i = 0; i != num_targets; ++i) {
+        defs[i] = cg.world.literal_qu32(options[i]->index(), enum_ptrn->location());
+        targets[i] = cg.basicblock({enum_ptrn->location().front(), "case"});
+    }
 
-        auto matcher_int = is_integer ? matcher : cg.world.extract(matcher, 0_u32, matcher->debug());
-        cg.cur_bb->match(matcher_int, otherwise, defs, targets, {location().front(), "match"});
-        auto mem = cg.cur_mem;
+    auto mem = cg.cur_mem;
+    Continuation* otherwise = nullptr;
+    if (num_targets != 0) {
+        otherwise = cg.basicblock({enum_ptrn->location().front(), "otherwise"});
+        cg.match(cg.world.extract(occ, 0_u32, occ->debug()), otherwise, defs, targets, {enum_ptrn->location().front(), "match"});
+    }
 
-        for (size_t i = 0; i != num_targets; ++i) {
+    for (size_t i = 0, e = options.size(); i != e; ++i) {
+        auto option_decl = options[i];
+        if (i < num_targets)
             cg.enter(targets[i], mem);
-            if (auto def = arm(i)->expr()->remit(cg))
-                cg.cur_bb->jump(join, {cg.cur_mem, def}, location().back());
+        else if (otherwise)
+            cg.enter(otherwise, mem);
+
+        // the args of the option become new columns
+        auto num_args = option_decl->num_args();
+        Array<const Def*> args(num_args);
+        if (num_args != 0) {
+            auto variant = cg.world.cast(option_decl->variant_type(cg), cg.world.extract(occ, 1, enum_ptrn->location()), enum_ptrn->location());
+            for (size_t j = 0; j != num_args; ++j)
+                args[j] = num_args == 1 ? variant : cg.world.extract(variant, j, enum_ptrn->location());
         }
 
-        bool no_otherwise = num_arms() == num_targets;
-        if (!no_otherwise) {
-            cg.enter(otherwise, mem);
-            if (auto def = arm(num_targets)->expr()->remit(cg))
-                cg.cur_bb->jump(join, {cg.cur_mem, def}, location().back());
+        Rows result;
+        for (auto&& row : rows) {
+            Array<const Ptrn*> ptrns(num_args, nullptr);
+            if (auto ptrn = row.ptrns[col] ? row.ptrns[col]->isa<EnumPtrn>() : nullptr) {
+                if (ptrn->path()->decl() != option_decl) continue;
+                for (size_t j = 0; j != num_args; ++j)
+                    ptrns[j] = ptrn->arg(j);
+            }
+            result.push_back(expand(row, col, ptrns));
         }
-    } else {
-        // general case: if/else
-        for (size_t i = 0, e = num_arms(); i != e; ++i) {
-            auto case_true  = cg.basicblock({arm(i)->location().front(), "case_true"});
-            auto case_false = cg.basicblock({arm(i)->location().front(), "case_false"});
 
-            arm(i)->ptrn()->emit(cg, matcher);
+        emit(result, expand(occs, col, args));
+    }
+
+    if (!complete) {
+        cg.enter(otherwise, mem);
+        Rows result;
+        for (auto&& row : rows) {
+            if (is_wildcard(row.ptrns[col]))
+                result.push_back(expand(row, col, {}));
+        }
+        emit(result, expand(occs, col, {}));
+    }
+}
+
+void DecisionTree::emit_literal(const Rows& rows, const std::vector<const Def*>& occs, size_t col, const Ptrn* literal_ptrn) {
+    auto occ = occs[col];
+
+    // distinct values in order of their first appearance - literals are hashed by thorin
+    std::vector<const Def*> values;
+    for (auto&& row : rows) {
+        if (!is_wildcard(row.ptrns[col])) {
+            auto value = row.ptrns[col]->emit(cg);
+            if (std::find(values.begin(), values.end(), value) == values.end())
+                values.push_back(value);
+        }
+    }
+
+    auto specialize = [&] (const Def* value) {
+        Rows result;
+        for (auto&& row : rows) {
+            if (is_wildcard(row.ptrns[col]) || row.ptrns[col]->emit(cg) == value)
+                result.push_back(expand(row, col, {}));
+        }
+        return result;
+    };
 
-            // last pattern will always be taken
-            auto cond = i == e - 1
-                ? cg.world.literal_bool(true, arm(i)->ptrn()->location())
-                : arm(i)->ptrn()->emit_cond(cg, matcher);
+    auto rest = expand(occs, col, {});
+    auto mem = cg.cur_mem;
+    auto location = literal_ptrn->location();
 
-            cg.cur_bb->branch(cond, case_true, case_false, arm(i)->ptrn()->location().back());
+    if (is_int(literal_ptrn->type())) {
+        // integers: match continuation
+        Array<Continuation*> targets(values.size());
+        for (size_t i = 0, e = values.size(); i != e; ++i)
+            targets[i] = cg.basicblock({location.front(), "case"});
+        auto otherwise = cg.basicblock({location.front(), "otherwise"});
+        cg.match(occ, otherwise, values, targets, {location.front(), "match"});
 
-            auto mem = cg.cur_mem;
+        for (size_t i = 0, e = values.size(); i != e; ++i) {
+            cg.enter(targets[i], mem);
+            emit(specialize(values[i]), rest);
+        }
+        cg.enter(otherwise, mem);
+    } else {
+        // other literals: chain of comparisons
+        for (auto value : values) {
+            auto case_true  = cg.basicblock({location.front(), "case_true"});
+            auto case_false = cg.basicblock({location.front(), "case_false"});
+            cg.branch(cg.world.cmp_eq(occ, value, location), case_true, case_false, location.back());
             cg.enter(case_true, mem);
-            if (auto def = arm(i)->expr()->remit(cg))
-                cg.cur_bb->jump(join, {cg.cur_mem, def}, arm(i)->location().back());
-
+            emit(specialize(value), rest);
             cg.enter(case_false, mem);
         }
     }
 
-    if (thorin_type)
+    Rows result;
+    for (auto&& row : rows) {
+        if (is_wildcard(row.ptrns[col]))
+            result.push_back(expand(row, col, {}));
+    }
+    emit(result, rest);
+}
+
+void DecisionTree::emit_leaf(size_t arm) {
+    auto& bb = arm_bbs[arm];
+    if (bb == nullptr) {
+        bb = cg.world.continuation(cg.world.fn_type({cg.world.mem_type()}), CC::C, Intrinsic::None, {match->arm(arm)->location().front(), "arm"});
+        bb->param(0)->debug().set("mem");
+        cg.join(bb);
+    }
+    cg.jump(bb, {cg.cur_mem}, match->arm(arm)->ptrn()->location().back());
+}
+
+const Def* MatchExpr::remit(CodeGen& cg) const {
+    auto thorin_type = cg.convert(type());
+
+    auto join = thorin_type ? cg.basicblock(thorin_type, {location().back(), "match_join"}) : nullptr; // TODO rewrite with bottom type
+    if (join) cg.join(join);
+
+    auto matcher = expr()->remit(cg);
+
+    DecisionTree tree(cg, this);
+    DecisionTree::Rows rows;
+    for (size_t i = 0, e = num_arms(); i != e; ++i)
+        rows.push_back({{arm(i)->ptrn()}, i});
+    tree.emit(rows, {matcher});
+
+    // each arm is emitted once - all leaves of the tree that select it jump there
+    for (size_t i = 0, e = num_arms(); i != e; ++i) {
+        auto bb = tree.arm_bb(i);
+        if (bb == nullptr) continue;
+
+        cg.seal(bb);
+        cg.enter(bb, bb->param(0));
+        arm(i)->ptrn()->emit(cg, matcher);
+        if (auto def = arm(i)->expr()->remit(cg))
+            cg.jump(join, {cg.cur_mem, def}, arm(i)->location().back());
+    }
+
+    if (thorin_type) {
+        cg.seal(join);
         return cg.enter(join);
+    }
     return nullptr; // TODO use bottom type
 }
 
@@ -907,20 +1774,29 @@ const Def* WhileExpr::remit(CodeGen& cg) const {
     auto cont_bb = cg.create_continuation(continue_decl());
     auto brk__bb = cg.create_continuation(break_decl());
 
-    cg.cur_bb->jump(head_bb, {cg.cur_mem}, cond()->location().back());
+    for (auto bb : {head_bb, body_bb, exit_bb, cont_bb, brk__bb})
+        cg.join(bb);
+
+    cg.jump(head_bb, {cg.cur_mem}, cond()->location().back());
 
+    // head_bb stays unsealed until the back edge from cont_bb is known
     cg.enter(head_bb, head_bb->param(0));
     cond()->emit_branch(cg, body_bb, exit_bb);
+    cg.seal(body_bb);
+    cg.seal(exit_bb);
 
     cg.enter(body_bb, body_bb->param(0));
     body()->remit(cg);
-    cg.cur_bb->jump(cont_bb, {cg.cur_mem}, body()->location().back());
+    cg.jump(cont_bb, {cg.cur_mem}, body()->location().back());
+    cg.seal(cont_bb);
 
     cg.enter(cont_bb, cont_bb->param(0));
-    cg.cur_bb->jump(head_bb, {cg.cur_mem}, body()->location().back());
+    cg.jump(head_bb, {cg.cur_mem}, body()->location().back());
+    cg.seal(head_bb);
 
     cg.enter(exit_bb, exit_bb->param(0));
-    cg.cur_bb->jump(brk__bb, {cg.cur_mem}, body()->location().back());
+    cg.jump(brk__bb, {cg.cur_mem}, body()->location().back());
+    cg.seal(brk__bb);
 
     cg.enter(brk__bb, brk__bb->param(0));
     return cg.world.tuple({}, location());
@@ -941,6 +1817,7 @@ const Def* ForExpr::remit(CodeGen& cg) const {
     auto fun = map_expr->lhs()->remit(cg);
 
     args.front() = cg.cur_mem; // now get the current memory monad
+    cg.set_parent(break_bb);
     cg.call(fun, args, nullptr, map_expr->location());
 
     cg.enter(break_bb, break_bb->param(0));
@@ -1042,7 +1919,19 @@ void ExprStmt::emit(CodeGen& cg) const { expr()->remit(cg); }
 void ItemStmt::emit(CodeGen& cg) const { item()->emit(cg); }
 
 void LetStmt::emit(CodeGen& cg) const {
-    ptrn()->emit(cg, init() ? init()->remit(cg) : cg.world.bottom(cg.convert(ptrn()->type()), ptrn()->location()));
+    THORIN_PUSH(cg.let_align, align());
+    // the local takes over the slot a large repeated array is filled in
+    if (auto repeated = init() ? init()->isa<RepeatedDefiniteArrayExpr>() : nullptr) {
+        if (auto id_ptrn = ptrn()->isa<IdPtrn>()) {
+            if (auto slot = repeated->emit_slot(cg, id_ptrn->local()->debug())) {
+                id_ptrn->local()->emit_slot(cg, slot);
+                return;
+            }
+        }
+    }
+
+    auto def = init() ? init()->remit(cg) : cg.world.bottom(cg.convert(ptrn()->type()), ptrn()->location());
+    ptrn()->emit(cg, def);
 }
 
 void AsmStmt::emit(CodeGen& cg) const {
@@ -1075,9 +1964,31 @@ void AsmStmt::emit(CodeGen& cg) const {
 
 //------------------------------------------------------------------------------
 
-void emit(World& world, const Module* mod) {
-    CodeGen cg(world);
+void emit(World& world, const Module* mod, bool branchless, bool mono, BackendHints& hints) {
+    CodeGen cg(world, branchless, mono);
     mod->emit(cg);
+    cg.emit_instances();
+    cg.finalize();
+    hints = cg.backend_hints();
+}
+
+void resolve(const World& world, BackendHints& hints) {
+    hints.fns.clear();
+    for (auto continuation : world.continuations()) {
+        auto i = hints.def_fns.find(def_key(continuation));
+        // the LLVM backend keeps the names of external functions and declarations and appends the gid to the others
+        if (i != hints.def_fns.end())
+            hints.fns.emplace(continuation->is_external() || continuation->empty() ? std::string(continuation->name()) : continuation->unique_name(), i->second);
+    }
+
+    hints.aligns.clear();
+    for (auto primop : world.primops()) {
+        if (primop->isa<Global>() || primop->isa<Slot>()) {
+            auto i = hints.def_aligns.find(def_key(primop));
+            if (i != hints.def_aligns.end())
+                hints.aligns.emplace(primop->unique_name(), i->second);
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -20,8 +20,8 @@ void init() {
     Token::init();
 }
 
-void check(std::unique_ptr<TypeTable>& typetable, const Module* mod, bool nossa) {
-    name_analysis(mod);
+void check(std::unique_ptr<TypeTable>& typetable, const Module* mod, bool nossa, bool unused_items) {
+    name_analysis(mod, unused_items);
     type_inference(typetable, mod);
     type_analysis(mod, nossa);
     //borrow_check(mod);
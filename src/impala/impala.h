@@ -15,18 +15,21 @@
 namespace impala {
 
 class ASTNode;
+struct BackendHints;
 class Item;
 class Module;
 typedef std::vector<std::unique_ptr<const Item>> Items;
 
 void init();
 void parse(Items&, std::istream&, const char*);
-void name_analysis(const Module*);
+void name_analysis(const Module*, bool unused_items);
 void type_inference(std::unique_ptr<TypeTable>& typetable, const Module*);
 void type_analysis(const Module*, bool nossa);
 //void borrow_check(const ModContents*);
-void check(std::unique_ptr<TypeTable>& typetable, const Module*, bool nossa);
-void emit(thorin::World&, const Module*);
+void check(std::unique_ptr<TypeTable>& typetable, const Module*, bool nossa, bool unused_items);
+void emit(thorin::World&, const Module*, bool branchless, bool mono, BackendHints&);
+/// Finds the defs @c emit recorded @p hints for in @p world - which may have been rebuilt since - and keys them by the names the LLVM backend gives them.
+void resolve(const thorin::World&, BackendHints&);
 
 enum class Prec {
     Bottom,
@@ -169,6 +169,7 @@ Token Lexer::lex() {
         if (accept('}')) return {location(), Token::R_BRACE};
         if (accept('~')) return {location(), Token::TILDE};
         if (accept('?')) return {location(), Token::KNOWN};
+        if (accept('#')) return {location(), Token::HASH};
 
         // '.', floats
         if (accept('.')) {
@@ -1,9 +1,45 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <future>
+#include <sstream>
 #include <vector>
 #include <cctype>
 #include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 #ifdef LLVM_SUPPORT
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Host.h>
+#if LLVM_VERSION_MAJOR >= 14
+#include <llvm/MC/TargetRegistry.h>
+#else
+#include <llvm/Support/TargetRegistry.h>
+#endif
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_os_ostream.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/IPO/AlwaysInliner.h>
+
 #include "thorin/be/llvm/llvm.h"
 #endif
 #include "thorin/analyses/schedule.h"
@@ -12,12 +48,15 @@
 #include "thorin/util/location.h"
 
 #include "impala/ast.h"
+#include "impala/cache.h"
 #include "impala/cgen.h"
 #include "impala/impala.h"
+#include "impala/lexer.h"
 
 //------------------------------------------------------------------------------
 
 typedef std::vector<std::string> Names;
+typedef std::chrono::steady_clock Clock;
 
 //------------------------------------------------------------------------------
 
@@ -29,22 +68,347 @@ std::ostream* open(std::ofstream& stream, const std::string& name) {
     return &stream;
 }
 
+/**
+ * Reports wall time and growth of the peak memory of each compiler phase on destruction - if enabled via -time-phases.
+ * The peak only grows, so a phase that needs less memory than an earlier one reports 0 KiB.
+ */
+class PhaseTimes {
+public:
+    PhaseTimes(bool enabled)
+        : enabled_(enabled)
+        , last_(Clock::now())
+        , last_peak_(enabled ? peak_memory() : 0)
+    {}
+    ~PhaseTimes() {
+        if (!enabled_)
+            return;
+        using ms = std::chrono::duration<double, std::milli>;
+        for (auto&& phase : phases_)
+            thorin::errf("phase {} {} ms {} KiB\n", phase.name, ms(phase.time).count(), phase.peak_growth);
+    }
+
+    /// Ends the phase @p name, which started at the end of the previous one.
+    void operator()(const char* name) {
+        if (!enabled_)
+            return;
+        auto now = Clock::now();
+        auto peak = peak_memory();
+        phases_.push_back({name, now - last_, peak - last_peak_});
+        last_ = now;
+        last_peak_ = peak;
+    }
+
+    explicit operator bool() const { return enabled_; }
+
+private:
+    /// Peak resident set size of the process in KiB so far; 0 if unknown.
+    static long peak_memory() {
+#ifdef _WIN32
+        return 0;
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    }
+
+    struct Phase {
+        const char* name;
+        Clock::duration time;
+        long peak_growth;
+    };
+
+    bool enabled_;
+    Clock::time_point last_;
+    long last_peak_;
+    std::vector<Phase> phases_;
+};
+
+#ifdef LLVM_SUPPORT
+/// The alignment for the global or alloca @p value in @p backend_hints - 0 if there is none.
+static uint32_t find_align(const impala::BackendHints& backend_hints, const llvm::Value& value) {
+    auto i = backend_hints.aligns.find(value.getName().str());
+    return i != backend_hints.aligns.end() ? i->second : 0;
+}
+
+/// Raises the alignment of @p global to @p align - a smaller one is left alone.
+static void raise_align(llvm::GlobalVariable& global, uint32_t align) {
+#if LLVM_VERSION_MAJOR >= 11
+    auto current = std::max<uint64_t>(global.getAlign().valueOrOne().value(), global.getParent()->getDataLayout().getPrefTypeAlign(global.getValueType()).value());
+    if (current < align)
+        global.setAlignment(llvm::Align(align));
+#else
+    auto current = std::max<uint64_t>(global.getAlignment(), global.getParent()->getDataLayout().getPrefTypeAlignment(global.getValueType()));
+    if (current < align)
+#if LLVM_VERSION_MAJOR >= 10
+        global.setAlignment(llvm::MaybeAlign(align));
+#else
+        global.setAlignment(align);
+#endif
+#endif
+}
+
+/// Raises the alignment of @p alloca to @p align - a smaller one is left alone.
+static void raise_align(llvm::AllocaInst& alloca, uint32_t align) {
+#if LLVM_VERSION_MAJOR >= 11
+    if (alloca.getAlign().value() < align)
+        alloca.setAlignment(llvm::Align(align));
+#else
+    if (alloca.getAlignment() < align)
+#if LLVM_VERSION_MAJOR >= 10
+        alloca.setAlignment(llvm::MaybeAlign(align));
+#else
+        alloca.setAlignment(align);
+#endif
+#endif
+}
+
+/// The alignment of @p type LLVM relies on - masked accesses of vectors only rely on the alignment of their lanes.
+#if LLVM_VERSION_MAJOR >= 11
+static llvm::Align abi_align(const llvm::Module& module, llvm::Type* type) { return module.getDataLayout().getABITypeAlign(type); }
+#else
+static unsigned abi_align(const llvm::Module& module, llvm::Type* type) { return module.getDataLayout().getABITypeAlignment(type); }
+#endif
+
+static bool has_prefix(const llvm::Function& f, const char* prefix) {
+    return f.getName().str().compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+/// Replaces the calls of the stand-ins for @c nontemporal_store, @c masked_load, @c masked_store and @c gather by what they stand for.
+static void lower_stand_ins(llvm::Module& module) {
+    using impala::BackendHints;
+    std::vector<llvm::Function*> stand_ins;
+    for (auto& f : module) {
+        if (has_prefix(f, BackendHints::nontemporal_store_prefix()) || has_prefix(f, BackendHints::masked_load_prefix()) ||
+            has_prefix(f, BackendHints::masked_store_prefix())      || has_prefix(f, BackendHints::gather_prefix()))
+            stand_ins.push_back(&f);
+    }
+
+    auto& context = module.getContext();
+    auto nontemporal = llvm::MDNode::get(context, llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 1)));
+    for (auto f : stand_ins) {
+        while (!f->use_empty()) {
+            auto call = llvm::cast<llvm::CallInst>(f->user_back());
+            auto arg = [&] (unsigned i) { return call->getArgOperand(i); };
+            llvm::IRBuilder<> builder(call);
+            if (has_prefix(*f, BackendHints::nontemporal_store_prefix())) {
+                auto store = builder.CreateStore(arg(1), arg(0));
+                store->setMetadata(llvm::LLVMContext::MD_nontemporal, nontemporal);
+            } else if (has_prefix(*f, BackendHints::masked_load_prefix())) {
+                auto type = arg(2)->getType();
+#if LLVM_VERSION_MAJOR >= 13
+                call->replaceAllUsesWith(builder.CreateMaskedLoad(type, arg(0), abi_align(module, type->getScalarType()), arg(1), arg(2)));
+#else
+                call->replaceAllUsesWith(builder.CreateMaskedLoad(arg(0), abi_align(module, type->getScalarType()), arg(1), arg(2)));
+#endif
+            } else if (has_prefix(*f, BackendHints::masked_store_prefix())) {
+                builder.CreateMaskedStore(arg(1), arg(0), abi_align(module, arg(1)->getType()->getScalarType()), arg(2));
+            } else {
+                // Thorin points to the whole array - the lanes point to its elements
+                auto type = arg(3)->getType();
+                auto elem = type->getScalarType();
+                auto base = builder.CreatePointerCast(arg(0), llvm::PointerType::get(elem, arg(0)->getType()->getPointerAddressSpace()));
+                auto ptrs = builder.CreateGEP(elem, base, arg(1));
+#if LLVM_VERSION_MAJOR >= 13
+                call->replaceAllUsesWith(builder.CreateMaskedGather(type, ptrs, abi_align(module, elem), arg(2), arg(3)));
+#else
+                call->replaceAllUsesWith(builder.CreateMaskedGather(ptrs, abi_align(module, elem), arg(2), arg(3)));
+#endif
+            }
+            call->eraseFromParent();
+        }
+        f->eraseFromParent();
+    }
+}
+
+/**
+ * Attaches what Thorin cannot express to @p module: function attributes, @c restrict params, the alignment of globals and slots and non-temporal and masked memory accesses.
+ * Functions marked @c inline are inlined right away as the module may not see another inliner.
+ */
+static void apply_backend_hints(llvm::Module& module, const impala::BackendHints& backend_hints) {
+    if (backend_hints.empty())
+        return;
+
+    if (backend_hints.has_stand_ins)
+        lower_stand_ins(module);
+
+    for (auto& global : module.globals()) {
+        if (auto align = find_align(backend_hints, global))
+            raise_align(global, align);
+    }
+
+    bool always_inline = false;
+    for (auto& f : module) {
+        if (f.isDeclaration())
+            continue;
+
+        if (!backend_hints.aligns.empty()) {
+            for (auto& bb : f) {
+                for (auto& inst : bb) {
+                    if (auto alloca = llvm::dyn_cast<llvm::AllocaInst>(&inst)) {
+                        if (auto align = find_align(backend_hints, *alloca))
+                            raise_align(*alloca, align);
+                    }
+                }
+            }
+        }
+
+        auto i = backend_hints.fns.find(f.getName().str());
+        if (i == backend_hints.fns.end())
+            continue;
+        auto& hints = i->second;
+
+        // clones of the function may have dropped unused params - then it is unclear which ones are left
+        if (hints.noalias.size() == f.arg_size()) {
+            for (auto& arg : f.args()) {
+                if (hints.noalias[arg.getArgNo()] && arg.getType()->isPointerTy())
+                    arg.addAttr(llvm::Attribute::NoAlias);
+            }
+        }
+
+        auto attributes = hints.attributes;
+        if (attributes.is_inline()) {
+            f.removeFnAttr(llvm::Attribute::NoInline);
+            f.addFnAttr(llvm::Attribute::AlwaysInline);
+            always_inline = true;
+        }
+        if (attributes.is_noinline()) {
+            f.removeFnAttr(llvm::Attribute::AlwaysInline);
+            f.removeFnAttr(llvm::Attribute::InlineHint);
+            f.addFnAttr(llvm::Attribute::NoInline);
+        }
+#if LLVM_VERSION_MAJOR >= 12
+        if (attributes.is_hot())
+            f.addFnAttr(llvm::Attribute::Hot);
+#endif
+        if (attributes.is_cold())
+            f.addFnAttr(llvm::Attribute::Cold);
+    }
+
+    if (always_inline) {
+        llvm::legacy::PassManager passes;
+        passes.add(llvm::createAlwaysInlinerLegacyPass());
+        passes.run(module);
+    }
+}
+
+/// Exposes the pipeline that Thorin's LLVM backend runs on its module once emitted - so the backend hints can be applied in between.
+struct CodeGenPipeline : thorin::CodeGen {
+    using thorin::CodeGen::optimize;
+};
+
+/**
+ * Emits the module of the LLVM backend @p cg, applies @p backend_hints and runs Thorin's pipeline for level @p opt on it.
+ * Emitting at level 0 defers that pipeline, so LLVM's optimizations - above all inlining - already see the hints.
+ */
+static std::unique_ptr<llvm::Module>& emit_module(thorin::CodeGen& cg, const impala::BackendHints& backend_hints, int opt, bool debug) {
+    auto& module = cg.emit(0, debug);
+    apply_backend_hints(*module, backend_hints);
+    (cg.*&CodeGenPipeline::optimize)(opt);
+    return module;
+}
+
+/// Lowers @p module in-process to an object file or - if @p bitcode is set - to a bitcode file @p name; this saves printing it as text and spawning clang to re-parse it.
+void emit_object(llvm::Module& module, const std::string& name, bool bitcode) {
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream stream(buffer);
+    if (bitcode) {
+        llvm::WriteBitcodeToFile(module, stream);
+    } else {
+        auto triple = module.getTargetTriple();
+        if (triple.empty())
+            triple = llvm::sys::getDefaultTargetTriple();
+
+        std::string error;
+        auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+        if (!target)
+            throw std::runtime_error("cannot emit '" + name + "': " + error);
+
+        std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(triple, llvm::sys::getHostCPUName(), "", llvm::TargetOptions(), llvm::Reloc::PIC_));
+        module.setDataLayout(machine->createDataLayout());
+
+        llvm::legacy::PassManager passes;
+#if LLVM_VERSION_MAJOR >= 10
+        bool failed = machine->addPassesToEmitFile(passes, stream, nullptr, llvm::CGFT_ObjectFile);
+#else
+        bool failed = machine->addPassesToEmitFile(passes, stream, nullptr, llvm::TargetMachine::CGFT_ObjectFile);
+#endif
+        if (failed)
+            throw std::runtime_error("target '" + triple + "' cannot emit object files");
+        passes.run(module);
+    }
+
+    std::ofstream file(name, std::ios::binary);
+    if (!file.write(buffer.data(), buffer.size()))
+        throw std::runtime_error("cannot write '" + name + "': " + std::generic_category().message(errno));
+}
+
+/**
+ * JIT-compiles @p module and calls its @c main with @p args.
+ * Symbols the module does not define are looked up in @p libs and then in the impala process itself.
+ * The module must be destroyed before the context of the backend that emitted it, which this function takes care of.
+ * Compile time is reported relative to @p start; returns the exit code of @c main.
+ */
+int run_module(std::unique_ptr<llvm::Module> module, const std::string& name, const Names& libs, std::vector<char*>& args, Clock::time_point start) {
+    for (const auto& lib : libs) {
+        std::string error;
+        if (llvm::sys::DynamicLibrary::LoadLibraryPermanently(lib.c_str(), &error))
+            throw std::runtime_error("cannot load '" + lib + "': " + error);
+    }
+    llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    std::string error;
+    std::unique_ptr<llvm::ExecutionEngine> engine(llvm::EngineBuilder(std::move(module)).setEngineKind(llvm::EngineKind::JIT).setErrorStr(&error).create());
+    if (!engine)
+        throw std::runtime_error("cannot run '" + name + "': " + error);
+
+    // looking up the address is what actually triggers compilation
+    auto address = engine->getFunctionAddress("main");
+    if (address == 0)
+        throw std::runtime_error("cannot run '" + name + "': no function 'main'");
+    auto entry = reinterpret_cast<int(*)(int, char**)>(address);
+
+    auto compiled = Clock::now();
+    int result = entry(int(args.size()) - 1, args.data());
+    auto finished = Clock::now();
+    std::fflush(stdout);
+
+    using ms = std::chrono::duration<double, std::milli>;
+    thorin::errf("compile time: {} ms\n", ms(compiled - start).count());
+    thorin::errf("execution time: {} ms\n", ms(finished - compiled).count());
+    return result;
+}
+#endif
+
 int main(int argc, char** argv) {
     try {
+        auto start = Clock::now();
         if (argc < 1)
             throw std::logic_error("bad number of arguments");
 
+        // everything behind -run belongs to the program to run
+        int num_args = int(std::find_if(argv, argv + argc, [] (const char* arg) { return std::strcmp(arg, "-run") == 0; }) - argv);
+        std::vector<char*> run_args(argv + std::min(num_args + 1, argc), argv + argc);
+
         std::string prgname = argv[0];
         Names infiles;
 #ifndef NDEBUG
         Names breakpoints;
         bool track_history;
 #endif
-        std::string out_name, log_name, log_level;
+        Names jit_libs;
+        std::string out_name, log_name, log_level, cache_dir, cache_size;
         bool help,
              emit_cint, emit_thorin, emit_ast, emit_annotated,
-             emit_llvm, opt_thorin, opt_s, opt_0, opt_1, opt_2, opt_3, debug,
-             nocleanup, nossa, fancy;
+             emit_llvm, emit_obj, emit_bc, opt_thorin, opt_s, opt_0, opt_1, opt_2, opt_3, debug,
+             nocleanup, nossa, nobranchless, nomono, fno_unused_items, funused_items, fancy, cache_stats, noconcurrent_backends, run, time_phases;
 
 #ifndef NDEBUG
 #define LOG_LEVELS "{error|warn|info|verbose|debug}"
@@ -62,6 +426,9 @@ int main(int argc, char** argv) {
             .add_option<bool>            ("track-history",      "", "track hisotry of names - useful for debugging", track_history, false)
 #endif
             .add_option<std::string>     ("o",                  "", "specifies the output module name", out_name, "")
+            .add_option<std::string>     ("cache-dir",          "<dir>", "reuse the outputs of identical previous compilations stored in <dir>", cache_dir, "")
+            .add_option<std::string>     ("cache-size",         "<MiB>", "evict least recently used entries once the cache exceeds this size", cache_size, "1024")
+            .add_option<bool>            ("cache-stats",        "", "print hit/miss statistics of the compilation cache", cache_stats, false)
             .add_option<bool>            ("O0",                 "", "reduce compilation time and make debugging produce the expected results (default)", opt_0, false)
             .add_option<bool>            ("O1",                 "", "optimize", opt_1, false)
             .add_option<bool>            ("O2",                 "", "optimize even more", opt_2, false)
@@ -72,14 +439,28 @@ int main(int argc, char** argv) {
             .add_option<bool>            ("emit-ast",           "", "emit AST of Impala program", emit_ast, false)
             .add_option<bool>            ("emit-c-interface",   "", "emit C interface from Impala code (experimental)", emit_cint, false)
             .add_option<bool>            ("emit-llvm",          "", "emit llvm from Thorin representation (implies -Othorin)", emit_llvm, false)
+            .add_option<bool>            ("emit-obj",           "", "like -emit-llvm but emit an object file instead of textual llvm for the CPU", emit_obj, false)
+            .add_option<bool>            ("emit-bc",            "", "like -emit-llvm but emit llvm bitcode instead of textual llvm for the CPU", emit_bc, false)
             .add_option<bool>            ("emit-thorin",        "", "emit textual Thorin representation of Impala program", emit_thorin, false)
+            .add_option<bool>            ("fno-unused-items",   "", "neither analyze nor emit functions and statics unreachable from 'main' and extern functions (default in release builds)", fno_unused_items, false)
+            .add_option<bool>            ("funused-items",      "", "analyze and emit all items - also reports errors in unreachable ones", funused_items, false)
+            .add_option<bool>            ("run",                "[args...]", "JIT-compile the CPU module and run its 'main' with [args...]; reports compile and execution time - must come last", run, false)
+            .add_option<Names>           ("jit-lib",            "<libs>", "load <libs> before running with -run, e.g. the rtmock library of the tests", jit_libs)
             .add_option<bool>            ("f",                  "", "use fancy output: Impala's AST dump uses only parentheses where necessary", fancy, false)
             .add_option<bool>            ("g",                  "", "emit debug information", debug, false)
+            .add_option<bool>            ("time-phases",        "", "print time and growth of the peak memory of each compiler phase to stderr; lexes all files once more on their own for the 'lex' phase", time_phases, false)
+            .add_option<bool>            ("noconcurrent-backends", "", "run the backends one after another instead of concurrently", noconcurrent_backends, false)
             .add_option<bool>            ("nocleanup",          "", "no clean-up phase", nocleanup, false)
-            .add_option<bool>            ("nossa",              "", "use slots + load/store instead of SSA construction", nossa, false);
+            .add_option<bool>            ("nossa",              "", "use slots + load/store instead of SSA construction", nossa, false)
+            .add_option<bool>            ("nobranchless",       "", "always lower '&&', '||' and if-expressions with branches instead of select", nobranchless, false)
+            .add_option<bool>            ("nomono",             "", "emit generic functions polymorphically instead of one instance per type arguments", nomono, false);
 
         // do cmdline parsing
-        cmd_parser.parse(argc, argv);
+        cmd_parser.parse(num_args, argv);
+        run |= num_args != argc;
+        if (emit_obj && emit_bc)
+            throw std::invalid_argument("-emit-obj and -emit-bc are mutually exclusive");
+        emit_llvm |= emit_obj || emit_bc || run;
         opt_thorin |= emit_llvm;
 
         impala::fancy() = fancy;
@@ -102,6 +483,12 @@ int main(int argc, char** argv) {
         if (opt_s + opt_0 + opt_1 + opt_2 + opt_3 > 1)
             throw std::invalid_argument("multiple optimization levels specified");
 
+        // check the cache size, which is shifted to bytes below
+        uint64_t cache_mib = 0;
+        if (cache_size.empty() || cache_size.find_first_not_of("0123456789") != std::string::npos
+                || (cache_mib = std::strtoull(cache_size.c_str(), nullptr, 10)) > (UINT64_MAX >> 20))
+            throw std::invalid_argument("cache size must be a number of MiB, got '" + cache_size + "'");
+
         int opt = 0;
         if (opt_s) opt = -1;
         else if (opt_1) opt = 1;
@@ -138,8 +525,41 @@ int main(int argc, char** argv) {
             }
         }
 
+#ifdef NDEBUG
+        bool unused_items = funused_items && !fno_unused_items;
+#else
+        bool unused_items = !fno_unused_items;
+#endif
+
+        // only compilations whose outputs are files can be cached
+        std::unique_ptr<impala::CompilationCache> cache;
+        if (!cache_dir.empty() && !run && (emit_llvm || emit_cint) && !emit_thorin && !emit_ast && !emit_annotated) {
+            cache = std::make_unique<impala::CompilationCache>(cache_dir, cache_mib << 20);
+            std::ostringstream flags;
+            flags << IMPALA_VERSION << ' ' << THORIN_VERSION << ' ' << module_name << ' ' << opt << opt_thorin << debug << nocleanup << nossa
+                  << nobranchless << nomono << unused_items << emit_llvm << emit_obj << emit_bc << emit_cint;
+            cache->hash(flags.str());
+            // rebuilding the compiler or thorin invalidates its entries even if the versions stay the same
+            auto executable = impala::CompilationCache::binary_path(nullptr);
+            cache->hash_file_stamp(executable.empty() ? prgname : executable);
+            cache->hash_file_stamp(impala::CompilationCache::binary_path(reinterpret_cast<const void*>(&impala::init)));
+            cache->hash_file_stamp(impala::CompilationCache::binary_path(reinterpret_cast<const void*>(&thorin::verify_mem)));
+            for (const auto& infile : infiles)
+                cache->hash_file(infile);
+
+            bool hit = cache->lookup(module_name);
+            if (cache_stats)
+                thorin::outf("cache {}: {} hits, {} misses, {} entries, {} bytes\n", hit ? "hit" : "miss",
+                             cache->hits(), cache->misses(), cache->num_entries(), cache->size());
+            if (hit)
+                return EXIT_SUCCESS;
+        }
+        std::vector<std::string> outputs;
+
+        PhaseTimes phase(time_phases);
         thorin::World world(module_name);
         impala::init();
+        phase("init");
 
 #if THORIN_ENABLE_CHECKS && !defined(NDEBUG)
         for (auto b : breakpoints) {
@@ -167,6 +587,18 @@ int main(int argc, char** argv) {
         world.enable_history(track_history);
 #endif
 
+        if (phase) {
+            // the parser drives the lexer, so lexing is measured in a pass of its own; this pass must not count errors twice
+            THORIN_PUSH(impala::num_errors(), impala::num_errors());
+            THORIN_PUSH(impala::num_warnings(), impala::num_warnings());
+            for (const auto& infile : infiles) {
+                std::ifstream file(infile);
+                impala::Lexer lexer(file, infile.c_str());
+                while (lexer.lex().tag() != impala::Token::Eof) {}
+            }
+            phase("lex");
+        }
+
         impala::Items items;
         for (const auto& infile : infiles) {
             auto filename = infile.c_str();
@@ -175,12 +607,19 @@ int main(int argc, char** argv) {
         }
 
         auto module = std::make_unique<const impala::Module>(infiles.front().c_str(), std::move(items));
+        phase("parse");
 
         if (emit_ast)
             module->stream(std::cout);
 
         std::unique_ptr<impala::TypeTable> typetable;
-        impala::check(typetable, module.get(), nossa);
+        // impala::check, phase by phase
+        impala::name_analysis(module.get(), unused_items);
+        phase("name");
+        impala::type_inference(typetable, module.get());
+        phase("infer");
+        impala::type_analysis(module.get(), nossa);
+        phase("type");
         bool result = impala::num_errors() == 0;
 
         if (emit_annotated)
@@ -208,41 +647,98 @@ int main(int argc, char** argv) {
                 return EXIT_FAILURE;
             }
             impala::generate_c_interface(module.get(), opts, out_file);
+            outputs.push_back(".h");
         }
 
-        if (result && (emit_llvm || emit_thorin))
-            impala::emit(world, module.get());
+        impala::BackendHints backend_hints;
+        if (result && (emit_llvm || emit_thorin)) {
+            impala::emit(world, module.get(), !nobranchless, !nomono, backend_hints);
+            phase("emit");
+            // some primops check their arguments only now
+            result = impala::num_errors() == 0;
+        }
 
         if (result) {
             thorin::verify_mem(world);
             if (!nocleanup)
                 world.cleanup();
-            if (opt_thorin)
+            phase("cleanup");
+            if (opt_thorin) {
                 world.opt();
+                phase("opt");
+            }
             if (emit_thorin)
                 world.dump();
             if (emit_llvm) {
 #ifdef LLVM_SUPPORT
                 thorin::Backends backends(world);
+                impala::resolve(world, backend_hints);
+                if (run) {
+                    if (backends.cuda_cg || backends.nvvm_cg || backends.opencl_cg || backends.amdgpu_cg || backends.hls_cg)
+                        thorin::outf("warning: -run only executes the CPU module - ignoring accelerator code\n");
+                    auto& cpu_module = emit_module(*backends.cpu_cg, backend_hints, opt, debug);
+                    phase("backends");
+                    run_args.insert(run_args.begin(), &module_name[0]);
+                    run_args.push_back(nullptr);
+                    return run_module(std::move(cpu_module), module_name, jit_libs, run_args, start);
+                }
+
                 auto emit_to_file = [&](thorin::CodeGen* cg, std::string ext) {
-                    if (cg) {
-                        auto name = module_name + ext;
-                        std::ofstream file(name);
-                        if (!file)
-                            throw std::runtime_error("cannot write '" + name + "': " + strerror(errno));
+                    auto name = module_name + ext;
+                    // backend hints only concern the CPU; its module goes to LLVM's codegen without a detour through text
+                    llvm::Module* cpu_module = nullptr;
+                    if (cg == backends.cpu_cg.get()) {
+                        cpu_module = emit_module(*cg, backend_hints, opt, debug).get();
+                        if (ext == ".o" || ext == ".bc")
+                            return emit_object(*cpu_module, name, emit_bc);
+                    }
+
+                    std::ofstream file(name);
+                    if (!file)
+                        throw std::runtime_error("cannot write '" + name + "': " + std::generic_category().message(errno));
+                    if (cpu_module) {
+                        llvm::raw_os_ostream llvm_stream(file);
+                        cpu_module->print(llvm_stream, nullptr);
+                    } else {
                         cg->emit(file, opt, debug);
                     }
                 };
-                emit_to_file(backends.cpu_cg.get(),    ".ll");
-                emit_to_file(backends.cuda_cg.get(),   ".cu");
-                emit_to_file(backends.nvvm_cg.get(),   ".nvvm");
-                emit_to_file(backends.opencl_cg.get(), ".cl");
-                emit_to_file(backends.amdgpu_cg.get(), ".amdgpu");
-                emit_to_file(backends.hls_cg.get(),    ".hls");
+
+                // the backends share no mutable state, so they run concurrently: each one emits a world of its own - Backends imported the kernels into new ones -
+                // to a module in an LLVMContext of its own and writes a file of its own; the backend hints are only read
+                llvm::InitializeNativeTarget();         // LLVM's target registry is shared - so it is set up before
+                llvm::InitializeNativeTargetAsmPrinter();
+                // thorin's log is shared but not synchronized - so it rules out concurrency if it goes to a file or is chatty enough to interleave
+                bool concurrent = !noconcurrent_backends && log_name == "-" && log_level == "error";
+                std::pair<thorin::CodeGen*, const char*> cgs[] = {
+                    { backends.cpu_cg.get(),    emit_obj ? ".o" : emit_bc ? ".bc" : ".ll" },
+                    { backends.cuda_cg.get(),   ".cu"     },
+                    { backends.nvvm_cg.get(),   ".nvvm"   },
+                    { backends.opencl_cg.get(), ".cl"     },
+                    { backends.amdgpu_cg.get(), ".amdgpu" },
+                    { backends.hls_cg.get(),    ".hls"    },
+                };
+                auto policy = concurrent ? std::launch::async : std::launch::deferred;
+                std::vector<std::future<void>> futures;
+                for (auto&& cg : cgs) {
+                    if (cg.first)
+                        futures.push_back(std::async(policy, emit_to_file, cg.first, cg.second));
+                }
+                // get rethrows the exception of a failed backend; the destructors of the other futures wait for them
+                for (auto& future : futures)
+                    future.get();
+                phase("backends");
+                for (auto&& cg : cgs) {
+                    if (cg.first)
+                        outputs.push_back(cg.second);
+                }
 #else
                 thorin::outf("warning: built without LLVM support - I don't emit an LLVM file\n");
 #endif
             }
+
+            if (cache && !outputs.empty())
+                cache->store(module_name, outputs);
         } else
             return EXIT_FAILURE;
 
@@ -21,7 +21,8 @@
     case Token::STATIC: \
     case Token::STRUCT: \
     case Token::TYPEDEF: \
-    case Token::TRAIT
+    case Token::TRAIT: \
+    case Token::HASH
 
 #define MOD_CONTENTS \
          VISIBILITY: \
@@ -126,6 +127,7 @@ public:
 #endif
 
     bool accept(TokenTag tok);
+    bool accept_restrict();
     bool expect(TokenTag tok, const std::string& context);
     void error(const std::string& what, const std::string& context) { error(what, context, lookahead()); }
     void error(const std::string& what, const std::string& context, const Token& tok);
@@ -174,9 +176,18 @@ public:
         expect(delimiter, context);
     }
 
+    /// Everything in the <tt>#[...]</tt> lists in front of an item or a let statement.
+    struct Attributes {
+        bool given = false;
+        FnAttributes fn;
+        uint32_t align = 0;
+    };
+
     // misc
     const Identifier* try_identifier(const std::string& what);
     Visibility parse_visibility();
+    Attributes parse_attributes();
+    FnAttributes parse_fn_attributes();
     uint64_t parse_integer(const char* what);
     int parse_addr_space();
     char char_value(const char*& p);
@@ -213,16 +224,17 @@ public:
 
     // items + helpers
     const Item*        parse_item();
+    const Item*        parse_item(Tracker, const Attributes&);
     void               parse_items(Items&);
-    const StaticItem*  parse_static_item(Tracker, Visibility);
+    const StaticItem*  parse_static_item(Tracker, Visibility, uint32_t align);
     const EnumDecl*    parse_enum_decl(Tracker, Visibility);
     const OptionDecl*  parse_option_decl(const size_t);
-    const FnDecl*      parse_fn_decl(BodyMode, Tracker, Visibility, bool is_extern, Symbol abi);
+    const FnDecl*      parse_fn_decl(BodyMode, Tracker, Visibility, FnAttributes, bool is_extern, Symbol abi);
     const ImplItem*    parse_impl(Tracker, Visibility);
     const Item*        parse_module_or_module_decl(Tracker, Visibility);
     const Module*      parse_module();
-    const Item*        parse_extern_block_or_fn_decl(Tracker, Visibility);
-    const StructDecl*  parse_struct_decl(Tracker, Visibility);
+    const Item*        parse_extern_block_or_fn_decl(Tracker, Visibility, FnAttributes);
+    const StructDecl*  parse_struct_decl(Tracker, Visibility, uint32_t align);
     const FieldDecl*   parse_field_decl(const size_t i);
     const TraitDecl*   parse_trait_decl(Tracker, Visibility);
     const Typedef*     parse_typedef(Tracker, Visibility);
@@ -258,8 +270,8 @@ public:
     const CharPtrn*    parse_char_ptrn();
 
     // statements
-    const ItemStmt* parse_item_stmt();
-    const LetStmt*  parse_let_stmt();
+    const Stmt*     parse_item_stmt();
+    const LetStmt*  parse_let_stmt(Tracker, uint32_t align);
     const AsmStmt*  parse_asm_stmt();
 
     // helpers
@@ -312,6 +324,16 @@ bool Parser::accept(TokenTag type) {
     return true;
 }
 
+/// @c restrict qualifies a pointer only if a type follows it - otherwise it is an identifier like any other.
+bool Parser::accept_restrict() {
+    if (lookahead() != Token::ID || lookahead().symbol() != "restrict")
+        return false;
+    switch (lookahead(1)) {
+        case TYPE: lex(); return true;
+        default:   return false;
+    }
+}
+
 bool Parser::expect(TokenTag tok, const std::string& context) {
     if (lookahead() == tok) {
         lex();
@@ -348,6 +370,49 @@ Visibility Parser::parse_visibility() {
     }
 }
 
+Parser::Attributes Parser::parse_attributes() {
+    auto tracker = track();
+    Attributes attributes;
+    while (accept(Token::HASH)) {
+        attributes.given = true;
+        expect(Token::L_BRACKET, "attributes");
+        parse_comma_list("closing bracket of attributes", Token::R_BRACKET, [&] {
+            if (lookahead() != Token::ID) {
+                error("attribute", "attributes");
+                return;
+            }
+            auto name = lex();
+            if (name.symbol() == "align") {
+                expect(Token::L_PAREN, "alignment");
+                auto align = parse_integer("alignment");
+                expect(Token::R_PAREN, "alignment");
+                // LLVM does not support larger alignments
+                if (align == 0 || (align & (align - 1)) != 0 || align > (1u << 29))
+                    impala::error(name.location(), "alignment must be a power of two not larger than 2^29");
+                else
+                    attributes.align = align;
+            } else if (auto attribute = FnAttributes::find(name.symbol()))
+                attributes.fn |= attribute;
+            else
+                impala::error(name.location(), "unknown attribute '{}'", name.symbol());
+        });
+    }
+
+    if (attributes.fn.is_inline() && attributes.fn.is_noinline())
+        impala::error(tracker, "function attributes 'inline' and 'noinline' exclude each other");
+    if (attributes.fn.is_hot() && attributes.fn.is_cold())
+        impala::error(tracker, "function attributes 'hot' and 'cold' exclude each other");
+    return attributes;
+}
+
+FnAttributes Parser::parse_fn_attributes() {
+    auto tracker = track();
+    auto attributes = parse_attributes();
+    if (attributes.align != 0)
+        impala::error(tracker, "alignment does not apply to functions");
+    return attributes.fn;
+}
+
 uint64_t Parser::parse_integer(const char* what) {
     switch (lookahead()) {
         case Token::LIT_i8:  return lex().box().get_s8();
@@ -496,19 +561,34 @@ const Param* Parser::parse_return_param() {
 
 const Item* Parser::parse_item() {
     auto tracker = track();
+    auto attributes = parse_attributes();
+    return parse_item(tracker, attributes);
+}
+
+const Item* Parser::parse_item(Tracker tracker, const Attributes& attributes) {
     auto vis = parse_visibility();
 
+    bool fn_item = lookahead() == Token::FN || lookahead() == Token::EXTERN;
+    bool aligned_item = lookahead() == Token::STATIC || lookahead() == Token::STRUCT;
+    if (attributes.given && !fn_item && (attributes.align == 0 || !attributes.fn.empty()))
+        error("function after function attributes", "item");
+    else if (attributes.align != 0 && !aligned_item)
+        impala::error(tracker, "alignment only applies to structs, static items and let statements");
+
     switch (lookahead()) {
         case Token::ENUM:    return parse_enum_decl(tracker, vis);
-        case Token::EXTERN:  return parse_extern_block_or_fn_decl(tracker, vis);
-        case Token::FN:      return parse_fn_decl(BodyMode::Mandatory, tracker, vis, /*extern*/ false, /*abi*/ "");
+        case Token::EXTERN:  return parse_extern_block_or_fn_decl(tracker, vis, attributes.fn);
+        case Token::FN:      return parse_fn_decl(BodyMode::Mandatory, tracker, vis, attributes.fn, /*extern*/ false, /*abi*/ "");
         case Token::IMPL:    return parse_impl(tracker, vis);
         case Token::MOD:     return parse_module_or_module_decl(tracker, vis);
-        case Token::STATIC:  return parse_static_item(tracker, vis);
-        case Token::STRUCT:  return parse_struct_decl(tracker, vis);
+        case Token::STATIC:  return parse_static_item(tracker, vis, attributes.align);
+        case Token::STRUCT:  return parse_struct_decl(tracker, vis, attributes.align);
         case Token::TRAIT:   return parse_trait_decl(tracker, vis);
         case Token::TYPEDEF: return parse_typedef(tracker, vis);
-        default: THORIN_UNREACHABLE;
+        default:
+            // only attributes without an item lead here - this has been reported above
+            assert(attributes.given);
+            return parse_fn_decl(BodyMode::Mandatory, tracker, vis, attributes.fn, /*extern*/ false, /*abi*/ "");
     }
 }
 
@@ -538,10 +618,12 @@ const OptionDecl* Parser::parse_option_decl(const size_t i) {
     return new OptionDecl(tracker, i, identifier, std::move(args));
 }
 
-const Item* Parser::parse_extern_block_or_fn_decl(Tracker tracker, Visibility vis) {
+const Item* Parser::parse_extern_block_or_fn_decl(Tracker tracker, Visibility vis, FnAttributes attributes) {
     eat(Token::EXTERN);
     if (lookahead() == Token::FN)
-        return parse_fn_decl(BodyMode::Mandatory, tracker, vis, /*extern*/ true, /*abi*/ "");
+        return parse_fn_decl(BodyMode::Mandatory, tracker, vis, attributes, /*extern*/ true, /*abi*/ "");
+    if (!attributes.empty())
+        impala::error(tracker, "function attributes do not apply to external blocks");
 
     Symbol abi;
     if (lookahead() == Token::LIT_str)
@@ -550,14 +632,14 @@ const Item* Parser::parse_extern_block_or_fn_decl(Tracker tracker, Visibility vi
     expect(Token::L_BRACE, "opening brace of external block");
     FnDecls fn_decls;
     while (lookahead() == Token::FN)
-        fn_decls.emplace_back(parse_fn_decl(BodyMode::None, tracker, vis, /*extern*/ true, abi));
+        fn_decls.emplace_back(parse_fn_decl(BodyMode::None, tracker, vis, FnAttributes(), /*extern*/ true, abi));
     expect(Token::R_BRACE, "closing brace of external block");
 
     return new ExternBlock(tracker, vis, abi, std::move(fn_decls));
 }
 
-const FnDecl* Parser::parse_fn_decl(BodyMode mode, Tracker tracker, Visibility vis, bool is_extern, Symbol abi) {
-    eat(Token::FN);
+const FnDecl* Parser::parse_fn_decl(BodyMode mode, Tracker tracker, Visibility vis, FnAttributes attributes, bool is_extern, Symbol abi) {
+    expect(Token::FN, "function declaration");
     auto export_name = lookahead() == Token::LIT_str ? lex().symbol() : Symbol();
 
     const Expr* pe_expr = parse_pe_expr("partial evaluation profile of function declaration");
@@ -578,7 +660,7 @@ const FnDecl* Parser::parse_fn_decl(BodyMode mode, Tracker tracker, Visibility v
             break;
     }
 
-    return new FnDecl(tracker, vis, is_extern, abi, pe_expr, export_name, identifier,
+    return new FnDecl(tracker, vis, attributes, is_extern, abi, pe_expr, export_name, identifier,
                       std::move(ast_type_params), std::move(params), body);
 }
 
@@ -595,8 +677,10 @@ const ImplItem* Parser::parse_impl(Tracker tracker, Visibility vis) {
         ast_type = type;
     expect(Token::L_BRACE, "impl");
     FnDecls methods;
-    while (lookahead() == Token::FN)
-        methods.emplace_back(parse_fn_decl(BodyMode::Mandatory, tracker, vis, /*exter*/ false, /*abi*/ ""));
+    while (lookahead() == Token::FN || lookahead() == Token::HASH) {
+        auto attributes = parse_fn_attributes();
+        methods.emplace_back(parse_fn_decl(BodyMode::Mandatory, tracker, vis, attributes, /*exter*/ false, /*abi*/ ""));
+    }
     expect(Token::R_BRACE, "closing brace of impl");
 
     return new ImplItem(tracker, vis, std::move(ast_type_params), trait, ast_type, std::move(methods));
@@ -633,17 +717,17 @@ void Parser::parse_items(Items& items) {
     }
 }
 
-const StaticItem* Parser::parse_static_item(Tracker tracker, Visibility vis) {
+const StaticItem* Parser::parse_static_item(Tracker tracker, Visibility vis, uint32_t align) {
     eat(Token::STATIC);
     bool mut = accept(Token::MUT);
     auto identifier = try_identifier("static item");
     auto ast_type = accept(Token::COLON) ? parse_type() : nullptr;
     auto init = accept(Token::ASGN) ? parse_expr() : nullptr;
     expect(Token::SEMICOLON, "static item");
-    return new StaticItem(tracker, vis, mut, identifier, ast_type, init);
+    return new StaticItem(tracker, vis, align, mut, identifier, ast_type, init);
 }
 
-const StructDecl* Parser::parse_struct_decl(Tracker tracker, Visibility vis) {
+const StructDecl* Parser::parse_struct_decl(Tracker tracker, Visibility vis, uint32_t align) {
     eat(Token::STRUCT);
     auto identifier = try_identifier("struct declaration");
     auto ast_type_params = parse_ast_type_params();
@@ -653,7 +737,7 @@ const StructDecl* Parser::parse_struct_decl(Tracker tracker, Visibility vis) {
     parse_comma_list("closing brace of struct declaration", Token::R_BRACE, [&] {
         field_decls.emplace_back(parse_field_decl(i++));
     });
-    return new StructDecl(tracker, vis, identifier, std::move(ast_type_params), std::move(field_decls));
+    return new StructDecl(tracker, vis, align, identifier, std::move(ast_type_params), std::move(field_decls));
 }
 
 const FieldDecl* Parser::parse_field_decl(const size_t i) {
@@ -679,8 +763,10 @@ const TraitDecl* Parser::parse_trait_decl(Tracker tracker, Visibility vis) {
 
     expect(Token::L_BRACE, "trait declaration");
     FnDecls methods;
-    while (lookahead() == Token::FN)
-        methods.emplace_back(parse_fn_decl(BodyMode::Optional, tracker, vis, /*exter*/ false, /*abi*/ ""));
+    while (lookahead() == Token::FN || lookahead() == Token::HASH) {
+        auto attributes = parse_fn_attributes();
+        methods.emplace_back(parse_fn_decl(BodyMode::Optional, tracker, vis, attributes, /*exter*/ false, /*abi*/ ""));
+    }
     expect(Token::R_BRACE, "closing brace of trait declaration");
 
     return new TraitDecl(tracker, vis, identifier, std::move(ast_type_params), std::move(super_traits), std::move(methods));
@@ -786,12 +872,14 @@ const PtrASTType* Parser::parse_ptr_type() {
     auto tracker = track();
     if (accept(Token::ANDAND)) {
         auto tag = accept(Token::MUT) ? PtrASTType::Mut : PtrASTType::Borrowed;
+        bool restricted = accept_restrict();
         auto addr_space = parse_addr_space();
         auto referenced_ast_type = parse_type();
-        return new PtrASTType(tracker, PtrASTType::Borrowed, 0, new PtrASTType(tracker, tag, addr_space, referenced_ast_type));
+        return new PtrASTType(tracker, PtrASTType::Borrowed, false, 0, new PtrASTType(tracker, tag, restricted, addr_space, referenced_ast_type));
     }
 
     PtrASTType::Tag tag;
+    bool restricted = false;
     if (accept(Token::TILDE))
         tag = PtrASTType::Owned;
     else {
@@ -800,11 +888,12 @@ const PtrASTType* Parser::parse_ptr_type() {
             tag = PtrASTType::Mut;
         else
             tag = PtrASTType::Borrowed;
+        restricted = accept_restrict();
     }
 
     auto addr_space = parse_addr_space();
     auto referenced_ast_type = parse_type();
-    return new PtrASTType(tracker, tag, addr_space, referenced_ast_type);
+    return new PtrASTType(tracker, tag, restricted, addr_space, referenced_ast_type);
 }
 
 const TupleASTType* Parser::parse_tuple_type() {
@@ -1228,7 +1317,7 @@ const BlockExpr* Parser::parse_block_expr() {
         switch (lookahead()) {
             case Token::SEMICOLON: lex(); continue; // ignore semicolon
             case ITEM:             stmts.emplace_back(parse_item_stmt()); continue;
-            case Token::LET:       stmts.emplace_back(parse_let_stmt()); continue;
+            case Token::LET:       stmts.emplace_back(parse_let_stmt(track(), 0)); continue;
             case Token::ASM:       stmts.emplace_back(parse_asm_stmt()); continue;
             case EXPR: {
                 auto tracker = track();
@@ -1359,18 +1448,24 @@ const CharPtrn* Parser::parse_char_ptrn() {
  * statements
  */
 
-const LetStmt* Parser::parse_let_stmt() {
-    auto tracker = track();
+const LetStmt* Parser::parse_let_stmt(Tracker tracker, uint32_t align) {
     eat(Token::LET);
     auto ptrn = parse_ptrn();
     auto init = accept(Token::ASGN) ? parse_expr() : nullptr;
     expect(Token::SEMICOLON, "the end of an let statement");
-    return new LetStmt(tracker, ptrn, init);
+    return new LetStmt(tracker, align, ptrn, init);
 }
 
-const ItemStmt* Parser::parse_item_stmt() {
+const Stmt* Parser::parse_item_stmt() {
     auto tracker = track();
-    auto item = parse_item();
+    auto attributes = parse_attributes();
+    // attributes may precede let statements as well
+    if (attributes.given && lookahead() == Token::LET) {
+        if (!attributes.fn.empty())
+            impala::error(tracker, "function attributes do not apply to let statements");
+        return parse_let_stmt(tracker, attributes.align);
+    }
+    auto item = parse_item(tracker, attributes);
     return new ItemStmt(tracker, item);
 }
 
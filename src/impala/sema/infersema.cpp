@@ -84,6 +84,8 @@ public:
             array[i] = args[i].get();
         return infer_call(lhs, array, call_type);
     }
+    /// The result type of a call @p map of a SIMD primop whose signature cannot express it - @c nullptr for other calls or while the args are unknown.
+    const Type* simd_primop_type(const MapExpr* map);
 
     const Type* rvalue(const Expr* expr) {
         auto type = infer(expr);
@@ -256,7 +258,8 @@ const Type* InferSema::unify(const Type* dst, const Type* src) {
                 if (src_owned_ptr_type->addr_space() == dst_borrowed_ptr_type->addr_space())
                     return borrowed_ptr_type(unify(dst->op(0), src->op(0)),
                                              dst_borrowed_ptr_type->is_mut(),
-                                             dst_borrowed_ptr_type->addr_space());
+                                             dst_borrowed_ptr_type->addr_space(),
+                                             dst_borrowed_ptr_type->is_restrict());
             }
         }
 
@@ -416,8 +419,8 @@ const Type* PrimASTType::infer(InferSema& sema) const {
 const Type* PtrASTType::infer(InferSema& sema) const {
     auto pointee = sema.infer(referenced_ast_type());
     switch (tag()) {
-        case Borrowed: return sema.borrowed_ptr_type(pointee, false, addr_space());
-        case Mut:      return sema.borrowed_ptr_type(pointee,  true, addr_space());
+        case Borrowed: return sema.borrowed_ptr_type(pointee, false, addr_space(), is_restrict());
+        case Mut:      return sema.borrowed_ptr_type(pointee,  true, addr_space(), is_restrict());
         case Owned:    return sema.   owned_ptr_type(pointee, addr_space());
     }
     THORIN_UNREACHABLE;
@@ -456,6 +459,20 @@ const Type* ASTTypeApp::infer(InferSema& sema) const {
         auto type = sema.find_type(decl());
         if (auto lambda = type->isa<Lambda>())
             return sema.reduce(lambda, ast_type_args(), type_args_);
+        if (auto struct_type = type->isa<StructType>()) {
+            auto struct_decl = struct_type->struct_decl();
+            if (num_ast_type_args() != 0 && num_ast_type_args() == struct_decl->num_ast_type_params()) {
+                Array<const Type*> args(num_ast_type_args());
+                bool identity = true;
+                for (size_t i = 0, e = args.size(); i != e; ++i) {
+                    args[i] = sema.infer(ast_type_arg(i));
+                    identity &= args[i] == sema.var(struct_decl->ast_type_param(i)->lambda_depth());
+                }
+                // a struct applied to its own type params - e.g. a field of type &List[T] in List[T] - is the struct itself
+                if (!identity)
+                    return sema.struct_instance(struct_type, args);
+            }
+        }
         return type;
     }
 
@@ -518,11 +535,15 @@ void ModuleDecl::infer(InferSema&) const {
 }
 
 void Module::infer(InferSema& sema) const {
-    for (auto&& item : items())
-        sema.infer_head(item.get());
+    for (auto&& item : items()) {
+        if (!item->is_dead())
+            sema.infer_head(item.get());
+    }
 
-    for (auto&& item : items())
-        sema.infer(item.get());
+    for (auto&& item : items()) {
+        if (!item->is_dead())
+            sema.infer(item.get());
+    }
 }
 
 void ExternBlock::infer(InferSema& sema) const {
@@ -870,6 +891,25 @@ const Type* InferSema::infer_call(const Expr* lhs, ArrayRef<const Expr*> args, c
     return type_error();
 }
 
+const Type* InferSema::simd_primop_type(const MapExpr* map) {
+    auto fn_decl = map->primop_decl();
+    if (fn_decl == nullptr)
+        return nullptr;
+
+    auto name = fn_decl->fn_symbol().remove_quotation();
+    if ((name == "reduce_add" || name == "reduce_min") && map->num_args() == 1) {
+        if (auto simd = find_type(map->arg(0))->isa<SimdType>())
+            return simd->elem_type();
+    } else if (name == "shuffle" && map->num_args() == 3) {
+        // as many lanes as the mask has
+        auto simd = find_type(map->arg(0))->isa<SimdType>();
+        auto mask = find_type(map->arg(2))->isa<SimdType>();
+        if (simd && mask)
+            return simd_type(simd->elem_type(), mask->dim());
+    }
+    return nullptr;
+}
+
 const Type* FieldExpr::infer(InferSema& sema) const {
     auto ltype = sema.infer(lhs());
     if (is_ptr(ltype)) {
@@ -952,8 +992,12 @@ const Type* MapExpr::infer(InferSema& sema) const {
         ltype = sema.infer(lhs());
     }
 
-    if (ltype->isa<FnType>())
-        return sema.infer_call(lhs(), args(), sema.find_type(this));
+    if (ltype->isa<FnType>()) {
+        auto type = sema.infer_call(lhs(), args(), sema.find_type(this));
+        if (auto simd_type = sema.simd_primop_type(this))
+            type = sema.unify(type, simd_type);
+        return type;
+    }
 
     return sema.type_error();
 }
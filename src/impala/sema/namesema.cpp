@@ -1,3 +1,5 @@
+#include <unordered_map>
+
 #include "impala/ast.h"
 #include "impala/impala.h"
 
@@ -29,6 +31,17 @@ public:
     void push_scope() { levels_.push_back(decl_stack_.size()); } ///< Opens a new scope.
     void pop_scope();                                            ///< Discards current scope.
 
+    /// Records that the top-level @p Item currently bound refers to @p decl.
+    void use(const Decl* decl) {
+        if (cur_item_ != nullptr && decl != nullptr) {
+            if (auto item = decl->isa<Item>())
+                uses_[cur_item_].push_back(item);
+        }
+    }
+
+    /// Marks all functions and statics of @p module as dead which are not reachable from @c main or @c extern functions.
+    void eliminate_dead_items(const Module* module);
+
     void bind_head(const Item* item) {
         if (item->is_no_decl()) {
             if (const auto& extern_block = item->isa<ExternBlock>()) {
@@ -45,9 +58,11 @@ private:
     thorin::HashMap<Symbol, const Decl*, Symbol::Hash> symbol2decl_;
     std::vector<const Decl*> decl_stack_;
     std::vector<size_t> levels_;
+    std::unordered_map<const Item*, std::vector<const Item*>> uses_;
 
 public: // HACK
     int lambda_depth_ = 0;
+    const Item* cur_item_ = nullptr;
 };
 
 //------------------------------------------------------------------------------
@@ -185,8 +200,10 @@ void Module::bind(NameSema& sema) const {
         if (item->is_named_decl())
             symbol2item_[item->symbol()] = item.get();
     }
-    for (auto&& item : items())
+    for (auto&& item : items()) {
+        THORIN_PUSH(sema.cur_item_, item.get());
         item->bind(sema);
+    }
     sema.pop_scope();
 }
 
@@ -324,6 +341,7 @@ void FnExpr::bind(NameSema& sema) const { fn_bind(sema); }
 
 void Path::bind(NameSema& sema) const {
     elem(0)->decl_ = sema.lookup(elem(0), elem(0)->symbol());
+    sema.use(elem(0)->decl_);
 }
 
 void PathExpr::bind(NameSema& sema) const {
@@ -467,9 +485,33 @@ void AsmStmt::bind(NameSema& sema) const {
 
 //------------------------------------------------------------------------------
 
-void name_analysis(const Module* module) {
+void NameSema::eliminate_dead_items(const Module* module) {
+    // impls are kept as method calls are only resolved during type inference
+    std::vector<const Item*> stack;
+    for (auto&& item : module->items()) {
+        auto fn_decl = item->isa<FnDecl>();
+        item->dead_ = (fn_decl && !fn_decl->is_extern() && fn_decl->symbol() != "main") || item->isa<StaticItem>();
+        if (!item->dead_)
+            stack.push_back(item.get());
+    }
+
+    while (!stack.empty()) {
+        auto item = stack.back();
+        stack.pop_back();
+        for (auto use : uses_[item]) {
+            if (use->dead_) {
+                use->dead_ = false;
+                stack.push_back(use);
+            }
+        }
+    }
+}
+
+void name_analysis(const Module* module, bool unused_items) {
     NameSema sema;
     module->bind(sema);
+    if (!unused_items)
+        sema.eliminate_dead_items(module);
 }
 
 //------------------------------------------------------------------------------
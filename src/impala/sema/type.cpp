@@ -72,6 +72,7 @@ bool is_subtype(const Type* dst, const Type* src) {
             return src_owned_ptr_type->addr_space() == dst_borrowed_ptr_type->addr_space()
                 && is_subtype(dst_borrowed_ptr_type->pointee(), src_owned_ptr_type->pointee());
         } else if (auto src_borrowed_ptr_type = src->isa<BorrowedPtrType>()) {
+            // restrict is a promise of the programmer and may be added or dropped in both directions
             return src_borrowed_ptr_type->addr_space() == dst_borrowed_ptr_type->addr_space()
                 && (src_borrowed_ptr_type->is_mut() || !dst_borrowed_ptr_type->is_mut())
                 && is_subtype(dst_borrowed_ptr_type->pointee(), src_borrowed_ptr_type->pointee());
@@ -127,6 +128,10 @@ uint64_t RefTypeBase::vhash() const {
     return thorin::hash_combine(Type::vhash(), ((uint64_t)addr_space() << 1) | uint64_t(is_mut()));
 }
 
+uint64_t PtrType::vhash() const {
+    return thorin::hash_combine(RefTypeBase::vhash(), uint64_t(is_restrict()));
+}
+
 uint64_t Var::vhash() const {
     return thorin::murmur3(uint64_t(tag()) << uint64_t(56) | uint8_t(depth()));
 }
@@ -143,6 +148,10 @@ bool RefTypeBase::equal(const Type* other) const {
         && this->addr_space() == other->as<RefTypeBase>()->addr_space();
 }
 
+bool PtrType::equal(const Type* other) const {
+    return RefTypeBase::equal(other) && this->is_restrict() == other->as<PtrType>()->is_restrict();
+}
+
 bool Var::equal(const Type* other) const {
     return other->isa<Var>() ? this->as<Var>()->depth() == other->as<Var>()->depth() : false;
 }
@@ -196,7 +205,12 @@ std::ostream& RefTypeBase::stream(std::ostream& os) const {
 std::ostream& DefiniteArrayType::stream(std::ostream& os) const { return streamf(os, "[{} * {}]", elem_type(), dim()); }
 std::ostream& IndefiniteArrayType::stream(std::ostream& os) const { return streamf(os, "[{}]", elem_type()); }
 std::ostream& SimdType::stream(std::ostream& os) const { return streamf(os, "simd[{} * {}]", elem_type(), dim()); }
-std::ostream& StructType::stream(std::ostream& os) const { return os << struct_decl()->symbol(); }
+std::ostream& StructType::stream(std::ostream& os) const {
+    os << struct_decl()->symbol();
+    if (generic())
+        stream_list(os, type_args(), [&](const Type* type) { os << type; }, "[", "]");
+    return os;
+}
 std::ostream& EnumType::stream(std::ostream& os) const { return os << enum_decl()->symbol(); }
 std::ostream& TupleType::stream(std::ostream& os) const {
     return stream_list(os, ops(), [&](const Type* type) { os << type; }, "(", ")");
@@ -219,7 +233,7 @@ const Type* EnumType           ::vrebuild(TypeTable&   , Types    ) const { retu
 const Type* DefiniteArrayType  ::vrebuild(TypeTable& to, Types ops) const { return to.  definite_array_type(ops[0], dim()); }
 const Type* SimdType           ::vrebuild(TypeTable& to, Types ops) const { return to.            simd_type(ops[0], dim()); }
 const Type* IndefiniteArrayType::vrebuild(TypeTable& to, Types ops) const { return to.indefinite_array_type(ops[0]); }
-const Type* BorrowedPtrType    ::vrebuild(TypeTable& to, Types ops) const { return to.borrowed_ptr_type(ops[0], is_mut(), addr_space()); }
+const Type* BorrowedPtrType    ::vrebuild(TypeTable& to, Types ops) const { return to.borrowed_ptr_type(ops[0], is_mut(), addr_space(), is_restrict()); }
 const Type* OwnedPtrType       ::vrebuild(TypeTable& to, Types ops) const { return to.   owned_ptr_type(ops[0], addr_space()); }
 const Type* RefType            ::vrebuild(TypeTable& to, Types ops) const { return to.      ref_type(ops[0], is_mut(), addr_space()); }
 const Type* InferError         ::vrebuild(TypeTable& to, Types ops) const { return to.infer_error(ops[0], ops[1]); }
@@ -247,6 +261,25 @@ const Type* Var::vreduce(int depth, const Type* type, Type2Type&) const {
 }
 
 const Type* StructType::vreduce(int depth, const Type* type, Type2Type& map) const {
+    if (generic()) {
+        Array<const Type*> args(num_type_args());
+        for (size_t i = 0, e = num_type_args(); i != e; ++i)
+            args[i] = type_arg(i)->reduce(depth, type, map);
+        return table().struct_instance(generic(), args);
+    }
+
+    if (auto num = struct_decl()->num_ast_type_params()) {
+        // a generic struct applied to its own type params
+        Array<const Type*> args(num);
+        bool changed = false;
+        for (size_t i = 0; i != num; ++i) {
+            auto var = table().var(struct_decl()->ast_type_param(i)->lambda_depth());
+            args[i] = var->reduce(depth, type, map);
+            changed |= args[i] != var;
+        }
+        return changed ? table().struct_instance(this, args) : this;
+    }
+
     auto struct_type = table().struct_type(struct_decl(), num_ops());
     map[this] = struct_type;
     for (size_t i = 0, e = num_ops(); i != e; ++i)
@@ -294,6 +327,77 @@ const StructType* TypeTable::struct_type(const StructDecl* decl, size_t size) {
     return type;
 }
 
+const StructType* TypeTable::struct_instance(const StructType* type, Types args) {
+    auto decl = type->struct_decl();
+    assert(args.size() == decl->num_ast_type_params());
+
+    auto& instance = struct_instances_[std::make_pair(type, std::vector<const Type*>(args.begin(), args.end()))];
+    if (instance == nullptr) {
+        auto struct_type = const_cast<StructType*>(this->struct_type(decl, type->num_ops()));
+        struct_type->generic_ = type;
+        struct_type->type_args_.assign(args.begin(), args.end());
+        instance = struct_type;
+    }
+
+    // mutually recursive structs refer to each other's instances - refresh each of them only once
+    if (refreshing_.insert(instance).second) {
+        Array<int> depths(args.size());
+        for (size_t i = 0, e = args.size(); i != e; ++i)
+            depths[i] = decl->ast_type_param(i)->lambda_depth();
+
+        Type2Type map;
+        map[type] = instance;
+        for (size_t i = 0, e = type->num_ops(); i != e; ++i)
+            instance->set(i, substitute(type->op(i), depths, args, map));
+        refreshing_.erase(instance);
+    }
+
+    return instance;
+}
+
+/// @p type with each @c Var of depth @p depths[i] replaced by @p args[i] - unlike @c reduce this does not shift the other vars.
+const Type* TypeTable::substitute(const Type* type, ArrayRef<int> depths, Types args, Type2Type& map) {
+    if (auto var = type->isa<Var>()) {
+        for (size_t i = 0, e = depths.size(); i != e; ++i) {
+            if (var->depth() == depths[i])
+                return args[i];
+        }
+        return var;
+    }
+
+    if (auto t = thorin::find(map, type))
+        return t;
+
+    if (auto struct_type = type->isa<StructType>()) {
+        if (auto generic = struct_type->generic()) {
+            Array<const Type*> nargs(struct_type->num_type_args());
+            for (size_t i = 0, e = nargs.size(); i != e; ++i)
+                nargs[i] = substitute(struct_type->type_arg(i), depths, args, map);
+            return map[type] = struct_instance(generic, nargs);
+        }
+
+        if (auto num = struct_type->struct_decl()->num_ast_type_params()) {
+            // another generic struct applied to its own type params
+            Array<const Type*> nargs(num);
+            bool changed = false;
+            for (size_t i = 0; i != num; ++i) {
+                auto var = this->var(struct_type->struct_decl()->ast_type_param(i)->lambda_depth());
+                nargs[i] = substitute(var, depths, args, map);
+                changed |= nargs[i] != var;
+            }
+            return map[type] = changed ? struct_instance(struct_type, nargs) : struct_type;
+        }
+    }
+
+    if (type->is_nominal() || type->num_ops() == 0)
+        return type;
+
+    Array<const Type*> ops(type->num_ops());
+    for (size_t i = 0, e = type->num_ops(); i != e; ++i)
+        ops[i] = substitute(type->op(i), depths, args, map);
+    return map[type] = type->rebuild(ops);
+}
+
 const EnumType* TypeTable::enum_type(const EnumDecl* decl, size_t size) {
     auto type = new EnumType(*this, decl, size);
     const auto& p = types_.insert(type);
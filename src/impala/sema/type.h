@@ -1,6 +1,9 @@
 #ifndef IMPALA_SEMA_TYPE_H
 #define IMPALA_SEMA_TYPE_H
 
+#include <map>
+#include <vector>
+
 #include "thorin/util/array.h"
 #include "thorin/util/cast.h"
 #include "thorin/util/hash.h"
@@ -117,25 +120,38 @@ private:
 /// Pointer @p Type.
 class PtrType : public RefTypeBase {
 protected:
-    PtrType(TypeTable& typetable, int tag, const Type* pointee, bool mut, int addr_space)
+    PtrType(TypeTable& typetable, int tag, const Type* pointee, bool mut, int addr_space, bool restricted)
         : RefTypeBase(typetable, tag, pointee, mut, addr_space)
+        , restricted_(restricted)
     {}
 
     std::ostream& stream_ptr_type(std::ostream&, std::string prefix, int addr_space, const Type* ref_type) const;
 
+public:
+    /// Is the pointee only accessed through this pointer while it lives? The backend lowers this to @c noalias.
+    bool is_restrict() const { return restricted_; }
+
+    virtual uint64_t vhash() const override;
+    virtual bool equal(const Type* other) const override;
+
 private:
     int addr_space_;
+    bool restricted_;
 
     friend class TypeTable;
 };
 
 class BorrowedPtrType : public PtrType {
 public:
-    BorrowedPtrType(TypeTable& typetable, const Type* pointee, bool mut, int addr_space)
-        : PtrType(typetable, Tag_borrowed_ptr, pointee, mut, addr_space)
+    BorrowedPtrType(TypeTable& typetable, const Type* pointee, bool mut, int addr_space, bool restricted)
+        : PtrType(typetable, Tag_borrowed_ptr, pointee, mut, addr_space, restricted)
     {}
 
-    virtual std::string prefix() const override { return is_mut() ? "&mut " : "&"; }
+    virtual std::string prefix() const override {
+        if (is_restrict())
+            return is_mut() ? "&mut restrict " : "&restrict ";
+        return is_mut() ? "&mut " : "&";
+    }
 
 private:
     virtual const Type* vrebuild(TypeTable&, Types) const override;
@@ -144,7 +160,7 @@ private:
 class OwnedPtrType : public PtrType {
 public:
     OwnedPtrType(TypeTable& typetable, const Type* pointee, int addr_space)
-        : PtrType(typetable, Tag_owned_ptr, pointee, true, addr_space)
+        : PtrType(typetable, Tag_owned_ptr, pointee, true, addr_space, false)
     {}
 
     virtual std::string prefix() const override { return "~"; }
@@ -307,6 +323,12 @@ private:
 public:
     const StructDecl* struct_decl() const { return decl_; }
     void set(size_t i, const Type* type) const { return const_cast<StructType*>(this)->Type::set(i, type); }
+    /// The generic struct this one is an instance of or @c nullptr.
+    const StructType* generic() const { return generic_; }
+    /// The type arguments the type params of @p generic() are replaced with.
+    Types type_args() const { return type_args_; }
+    size_t num_type_args() const { return type_args_.size(); }
+    const Type* type_arg(size_t i) const { return type_args_[i]; }
 
 private:
     virtual const Type* vrebuild(TypeTable& to, Types ops) const override;
@@ -314,6 +336,8 @@ private:
     virtual std::ostream& stream(std::ostream&) const override;
 
     const StructDecl* decl_;
+    const StructType* generic_ = nullptr;
+    std::vector<const Type*> type_args_;
 
     friend class TypeTable;
 };
@@ -500,6 +524,11 @@ public:
     const TupleType* unit() { return unit_; }
 
     const StructType* struct_type(const StructDecl* decl, size_t size);
+    /**
+     * The instance of the generic struct @p type whose type params are replaced by @p args all at once.
+     * Each instance is created once; its fields are refreshed on each call as inference may still refine the ones of @p type.
+     */
+    const StructType* struct_instance(const StructType* type, Types args);
     const EnumType* enum_type(const EnumDecl* decl, size_t size);
 
 #define IMPALA_TYPE(itype, atype) const PrimType* type_##itype() { return itype##_; }
@@ -513,8 +542,8 @@ public:
         return unify(new IndefiniteArrayType(*this, elem_type));
     }
     const SimdType* simd_type(const Type* elem_type, uint64_t size) { return unify(new SimdType(*this, elem_type, size)); }
-    const BorrowedPtrType* borrowed_ptr_type(const Type* pointee, bool mut, int addr_space) {
-        return unify(new BorrowedPtrType(*this, pointee, mut, addr_space));
+    const BorrowedPtrType* borrowed_ptr_type(const Type* pointee, bool mut, int addr_space, bool restricted = false) {
+        return unify(new BorrowedPtrType(*this, pointee, mut, addr_space, restricted));
     }
     const OwnedPtrType* owned_ptr_type(const Type* pointee, int addr_space) {
         return unify(new OwnedPtrType(*this, pointee, addr_space));
@@ -529,6 +558,10 @@ public:
     const InferError* infer_error(const Type* dst, const Type* src);
 
 private:
+    const Type* substitute(const Type*, ArrayRef<int> depths, Types args, Type2Type&);
+
+    std::map<std::pair<const StructType*, std::vector<const Type*>>, const StructType*> struct_instances_;
+    TypeSet refreshing_;
     const TupleType* unit_;
     const NoRetType* type_noret_;
     const TypeError* type_error_;
@@ -1,3 +1,4 @@
+#include <functional>
 #include <sstream>
 
 #include "impala/ast.h"
@@ -105,6 +106,8 @@ public:
             array[i] = args[i].get();
         check_call(expr, array);
     }
+    void check_simd_primop(const MapExpr* map);
+    void check_static_cycles();
 
 private:
     bool nossa_;
@@ -112,11 +115,40 @@ private:
 public:
     const BlockExpr* cur_block_ = nullptr;
     const Fn* cur_fn_ = nullptr;
+    const Expr* cur_callee_ = nullptr;
+    const StaticItem* cur_static_ = nullptr;   ///< static whose initializer is checked - @c nullptr within functions
+    const PathExpr* addressed_ = nullptr;      ///< path at the root of the operand of the innermost '&' or '&mut'
+    thorin::GIDSet<const LocalDecl*> loop_continuations_;
+    std::vector<const StaticItem*> statics_;
+    thorin::GIDMap<const StaticItem*, std::vector<std::pair<const StaticItem*, const PathExpr*>>> static_deps_; ///< immutable statics read by initializers
 };
 
 void type_analysis(const Module* module, bool nossa) {
     TypeSema sema(nossa);
     sema.check(module);
+    sema.check_static_cycles();
+}
+
+void TypeSema::check_static_cycles() {
+    // initializers are evaluated at compile time in dependency order - a cycle has no value to start with
+    enum { Unvisited, OnStack, Done };
+    thorin::GIDMap<const StaticItem*, int> state;
+    std::function<void(const StaticItem*)> visit = [&] (const StaticItem* item) {
+        state[item] = OnStack;
+        for (auto&& dep : static_deps_[item]) {
+            auto s = state[dep.first];
+            if (s == OnStack)
+                error(dep.second, "cyclic initializer: static '{}' depends on itself", dep.first->symbol());
+            else if (s == Unvisited)
+                visit(dep.first);
+        }
+        state[item] = Done;
+    };
+
+    for (auto item : statics_) {
+        if (state[item] == Unvisited)
+            visit(item);
+    }
 }
 
 template<class T>
@@ -230,8 +262,10 @@ void ModuleDecl::check(TypeSema&) const {
 }
 
 void Module::check(TypeSema& sema) const {
-    for (auto&& item : items())
-        sema.check(item.get());
+    for (auto&& item : items()) {
+        if (!item->is_dead())
+            sema.check(item.get());
+    }
 }
 
 void ExternBlock::check(TypeSema& sema) const {
@@ -280,8 +314,11 @@ void FnDecl::check(TypeSema& sema) const {
 }
 
 void StaticItem::check(TypeSema& sema) const {
-    if (init())
+    sema.statics_.push_back(this);
+    if (init()) {
+        THORIN_PUSH(sema.cur_static_, this);
         sema.check(init());
+    }
     sema.expect_known(this);
 }
 
@@ -321,6 +358,7 @@ void StrExpr::check(TypeSema&) const {}
 
 void FnExpr::check(TypeSema& sema) const {
     THORIN_PUSH(sema.cur_fn_, this);
+    THORIN_PUSH(sema.cur_static_, nullptr);
     assert(ast_type_params().empty());
 
     for (size_t i = 0, e = num_params(); i != e; ++i)
@@ -337,13 +375,39 @@ void PathExpr::check(TypeSema& sema) const {
             // if local lies in an outer function go through memory to implement closure
             if (local->is_mut() && (sema.nossa() || local->fn() != sema.cur_fn_))
                 local->take_address();
+            // jumps to loop continuations can only be tracked if they are called directly
+            if (sema.loop_continuations_.contains(local) && (sema.cur_callee_ != this || local->fn() != sema.cur_fn_))
+                local->fn()->has_escaping_continuation_ = true;
+        } else if (auto static_item = value_decl()->isa<StaticItem>()) {
+            // initializers have no memory to load from - they may only take the address of a mutable static
+            if (sema.cur_static_ && !static_item->is_mut())
+                sema.static_deps_[sema.cur_static_].emplace_back(static_item, this);
+            else if (sema.cur_static_ && sema.addressed_ != this)
+                error(this, "initializer of static '{}' reads mutable static '{}'; only its address may be taken", sema.cur_static_->symbol(), static_item->symbol());
         }
     } else
         error(this, "expected value but found '{}'", path());
 }
 
+/// The path whose address '&' or '&mut' takes when applied to @p expr - @c nullptr if there is none.
+static const PathExpr* lvalue_root(const Expr* expr) {
+    while (true) {
+        expr = expr->skip_rvalue();
+        auto map = expr->isa<MapExpr>();
+        if (auto field = expr->isa<FieldExpr>())
+            expr = field->lhs();
+        else if (map && !unpack_ref_type(map->lhs()->type())->isa<FnType>())
+            expr = map->lhs();
+        else
+            return expr->isa<PathExpr>();
+    }
+}
+
 void PrefixExpr::check(TypeSema& sema) const {
-    sema.check(rhs());
+    {
+        THORIN_PUSH(sema.addressed_, tag() == AND || tag() == MUT ? lvalue_root(rhs()) : nullptr);
+        sema.check(rhs());
+    }
 
     switch (tag()) {
         case AND:
@@ -585,7 +649,6 @@ void StructExpr::check(TypeSema& sema) const {
 
 void FieldExpr::check(TypeSema& sema) const {
     auto type = unpack_ref_type(sema.check(lhs()));
-
     if (auto struct_type = type->isa<StructType>()) {
         auto struct_decl = struct_type->struct_decl();
         if (auto field_decl = struct_decl->field_decl(symbol()))
@@ -600,7 +663,11 @@ void TypeAppExpr::check(TypeSema& /*sema*/) const {
 }
 
 void MapExpr::check(TypeSema& sema) const {
-    auto ltype = unpack_ref_type(sema.check(lhs()));
+    const Type* ltype;
+    {
+        THORIN_PUSH(sema.cur_callee_, lhs());
+        ltype = unpack_ref_type(sema.check(lhs()));
+    }
 
     for (auto&& arg : args())
         sema.check(arg.get());
@@ -608,9 +675,15 @@ void MapExpr::check(TypeSema& sema) const {
     if (ltype->isa<FnType>()) {
         if (!type()->is_known())
             error(this, "cannot infer type for function call");
-        return sema.check_call(lhs(), args());
+        sema.check_call(lhs(), args());
+        return sema.check_simd_primop(this);
     }
 
+    // fields and constant subscripts of locals in registers are extracted and inserted, but a dynamic subscript
+    // of an array in registers would spill it to a fresh slot on every access - such arrays better stay in memory
+    if (lhs()->type()->isa<RefType>() && ltype->isa<ArrayType>() && !ltype->isa<SimdType>() && num_args() == 1 && !arg(0)->isa<LiteralExpr>())
+        lhs()->take_address();
+
     if (ltype->isa<ArrayType>()) {
         if (num_args() == 1)
             sema.expect_int(arg(0), "for array subscript");
@@ -644,6 +717,69 @@ void TypeSema::check_call(const Expr* expr, ArrayRef<const Expr*> args) {
               args.size(), std::max(size_t(0), fn_type->num_params() - (fn_type->is_returning() ? 1 : 0)));
 }
 
+void TypeSema::check_simd_primop(const MapExpr* map) {
+    auto fn_decl = map->primop_decl();
+    if (fn_decl == nullptr)
+        return;
+
+    auto name = fn_decl->fn_symbol().remove_quotation();
+    // checks that arg i is a simd vector with dim lanes - with any number of lanes if dim is 0 - and returns its number of lanes
+    auto expect_simd = [&] (size_t i, uint64_t dim, const char* what) -> uint64_t {
+        auto arg = map->arg(i);
+        auto type = unpack_ref_type(arg->type());
+        if (type->isa<TypeError>() || !type->is_known())
+            return dim;
+        if (auto simd_type = type->isa<SimdType>()) {
+            if (dim != 0 && simd_type->dim() != dim)
+                error(arg, "mismatched number of lanes: expected {} but found {} as {} of '{}'", dim, simd_type->dim(), what, name);
+            return simd_type->dim();
+        }
+        error(arg, "mismatched types: expected simd type but found '{}' as {} of '{}'", type, what, name);
+        return dim;
+    };
+
+    if (name == "reduce_add" || name == "reduce_min") {
+        if (map->num_args() != 1)
+            return;
+        expect_simd(0, 0, "argument");
+        expect_num(map->arg(0), "argument of '{}'", name);
+    } else if (name == "shuffle") {
+        if (map->num_args() != 3)
+            return;
+        auto dim = expect_simd(0, 0, "first argument");
+        expect_simd(1, dim, "second argument");
+        expect_simd(2, 0, "mask");
+        expect_int(map->arg(2), "mask of '{}'", name);
+        // LLVM only shuffles by constant masks; lane i selects lane i of the first vector, lane dim + i of the second one
+        if (auto mask = map->arg(2)->isa<SimdExpr>()) {
+            for (auto&& lane : mask->args()) {
+                auto literal = lane->isa<LiteralExpr>();
+                if (dim != 0 && (literal == nullptr || literal->get_u64() >= 2 * dim))
+                    error(lane.get(), "lanes of the mask of '{}' must be literals below {}", name, 2 * dim);
+            }
+        } else {
+            error(map->arg(2), "mask of '{}' must be a simd expression of literals", name);
+        }
+    } else if (name == "masked_load" || name == "masked_store") {
+        if (map->num_args() != 3)
+            return;
+        // masked_load(ptr, mask, passthru) and masked_store(ptr, value, mask)
+        size_t value = name == "masked_load" ? 2 : 1;
+        size_t mask = name == "masked_load" ? 1 : 2;
+        auto dim = expect_simd(value, 0, value == 1 ? "value" : "value of the masked-off lanes");
+        expect_simd(mask, dim, "mask");
+        expect_bool(map->arg(mask), "mask of '{}'", name);
+    } else if (name == "gather") {
+        if (map->num_args() != 4)
+            return;
+        auto dim = expect_simd(3, 0, "value of the masked-off lanes");
+        expect_simd(1, dim, "indices");
+        expect_int(map->arg(1), "indices of '{}'", name);
+        expect_simd(2, dim, "mask");
+        expect_bool(map->arg(2), "mask of '{}'", name);
+    }
+}
+
 void BlockExpr::check(TypeSema& sema) const {
     THORIN_PUSH(sema.cur_block_, this);
     for (auto&& stmt : stmts())
@@ -720,6 +856,8 @@ void WhileExpr::check(TypeSema& sema) const {
     sema.expect_bool(cond(), "while-condition");
     sema.check(break_decl());
     sema.check(continue_decl());
+    sema.loop_continuations_.insert(break_decl());
+    sema.loop_continuations_.insert(continue_decl());
     sema.check(body());
 
     if (!is_no_ret_or_type_error(body()->type()))
@@ -128,7 +128,7 @@ std::ostream& Param::stream(std::ostream& os) const {
  */
 
 std::ostream& Module::stream(std::ostream& os) const {
-    return stream_list(os, items(), [&](const auto& item) { os << item.get() << endl; }, "", "", "", true);
+    return stream_list(os, items(), [&](const auto& item) { if (!item->is_dead()) os << item.get() << endl; }, "", "", "", true);
 }
 
 std::ostream& ModuleDecl::stream(std::ostream& os) const {
@@ -145,6 +145,7 @@ std::ostream& ExternBlock::stream(std::ostream& os) const {
 }
 
 std::ostream& FnDecl::stream(std::ostream& os) const {
+    os << attributes().str();
     if (is_extern())
         os << "extern ";
     os << "fn ";
@@ -191,15 +192,21 @@ std::ostream& OptionDecl::stream(std::ostream& os) const {
     }
 }
 
+std::ostream& stream_align(std::ostream& os, uint32_t align) {
+    if (align != 0)
+        os << "#[align(" << align << ")] ";
+    return os;
+}
+
 std::ostream& StaticItem::stream(std::ostream& os) const {
-    streamf(os, "static {} {}: {}", is_mut() ? "mut " : "", identifier(), type() ? type()->to_string() : ast_type()->to_string());
+    streamf(stream_align(os, align()), "static {} {}: {}", is_mut() ? "mut " : "", identifier(), type() ? type()->to_string() : ast_type()->to_string());
     if (init())
         streamf(os, " = {}", init());
     return os << ";";
 }
 
 std::ostream& StructDecl::stream(std::ostream& os) const {
-    stream_ast_type_params(streamf(os, "{}struct {}", visibility().str(), symbol())) << " {" << up << endl;
+    stream_ast_type_params(streamf(stream_align(os, align()), "{}struct {}", visibility().str(), symbol())) << " {" << up << endl;
     return stream_list(os, field_decls(), [&](const auto& field) { os << field.get(); }, "", "", ",", true) << down << endl << "}";
 }
 
@@ -534,7 +541,7 @@ std::ostream& CharPtrn::stream(std::ostream& os) const {
 std::ostream& ItemStmt::stream(std::ostream& os) const { return os << item(); }
 
 std::ostream& LetStmt::stream(std::ostream& os) const {
-    os << "let " << ptrn();
+    stream_align(os, align()) << "let " << ptrn();
     if (init())
         os << " = " << init();
     return os << ';';
@@ -1,10 +1,19 @@
+#include <algorithm>
 #include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Type.h>
 
+#include "thorin/util/args.h"
+
 #include "impala/ast.h"
 #include "impala/impala.h"
 
@@ -17,16 +26,58 @@ static const char * const IntrinsicNameTable[] = {
 };
 
 const impala::Type* llvm2impala(impala::TypeTable&, llvm::Type*);
+std::vector<std::string> split(const std::string& list);
+std::vector<llvm::Type*> overload_types(llvm::LLVMContext&, const std::string& elems, const std::string& widths);
+bool accepts(llvm::Intrinsic::ID, llvm::Type*);
+bool matches(llvm::Intrinsic::ID, llvm::FunctionType*);
+
+int main(int argc, char** argv) {
+    std::string elems, widths, prefixes;
+    bool help;
+    auto cmd_parser = thorin::ArgParser()
+        .add_option<bool>       ("help",     "",               "produce this help message", help, false)
+        .add_option<std::string>("types",    "<t1,t2,...>",    "element types to instantiate overloaded intrinsics with", elems, "f32,f64,i32,i64")
+        .add_option<std::string>("widths",   "<w1,w2,...>",    "vector widths to instantiate overloaded intrinsics with; 1 means scalar", widths, "1,2,4,8,16")
+        .add_option<std::string>("prefixes", "<p1,p2,...>",    "only emit intrinsics whose LLVM name starts with one of these, e.g. 'llvm.x86.'; all if empty", prefixes, "");
+    cmd_parser.parse(argc, argv);
+    if (help) {
+        std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+        cmd_parser.print_help();
+        return EXIT_SUCCESS;
+    }
 
-int main() {
     impala::init();
     std::unique_ptr<impala::TypeTable> typetable;
 
     auto module = std::make_unique<impala::Module>("dummy.impala");
-    check(typetable, module.get(), false);
+    check(typetable, module.get(), false, true);
 
     llvm::LLVMContext context;
     int num = llvm::Intrinsic::num_intrinsics - 1;
+    auto types = overload_types(context, elems, widths);
+    auto wanted_prefixes = split(prefixes);
+
+    auto emit = [&] (const std::string& llvm_name, const std::string& name, const impala::Type* itype) {
+        std::cout << thorin::endl;
+        auto fn = itype->as<impala::FnType>();
+        std::cout << "fn \"" << llvm_name << "\" " << name << "(";
+        for (size_t i = 0, e = fn->num_params()-1; i != e; ++i) {
+            std::cout << fn->param(i);
+            if (i != e-1)
+                std::cout << ", ";
+        }
+        if (fn->return_type()->isa<impala::NoRetType>())
+            std::cout << ") -> !;";
+        else
+            std::cout << ") -> " << fn->return_type() << ';';
+    };
+    auto impala_name = [] (const std::string& llvm_name) {
+        assert(llvm_name.substr(0, 5) == "llvm.");
+        std::string name = llvm_name.substr(5); // remove 'llvm.' prefix
+        // replace '.' with '_'
+        std::transform(name.begin(), name.end(), name.begin(), [] (char c) { return c == '.' ? '_' : c; });
+        return name;
+    };
 
     std::cout << "extern \"device\" {" << thorin::up;
     for (int i = 1; i != num; ++i) {
@@ -40,35 +91,142 @@ int main() {
         // skip "experimental" intrinsics
         if (llvm_name.find("experimental")!=std::string::npos)
             continue;
-        assert(llvm_name.substr(0, 5) == "llvm.");
-        std::string name = llvm_name.substr(5); // remove 'llvm.' prefix
-        // replace '.' with '_'
-        std::transform(name.begin(), name.end(), name.begin(), [] (char c) { return c == '.' ? '_' : c; });
+        if (!wanted_prefixes.empty() && std::none_of(wanted_prefixes.begin(), wanted_prefixes.end(),
+                                                     [&] (const std::string& prefix) { return llvm_name.compare(0, prefix.size(), prefix) == 0; }))
+            continue;
+        auto name = impala_name(llvm_name);
 
         if (llvm::Intrinsic::isOverloaded(id)) {
-            std::cout << thorin::endl;
-            std::cout << "// fn \"" << llvm_name << "\" " << name;
-            std::cout << " (...) -> (...); // is overloaded";
-        } else {
-            if (auto itype = llvm2impala(*typetable, llvm::Intrinsic::getType(context, id))) {
+            bool instantiated = false;
+            for (auto type : types) {
+                if (!accepts(id, type))
+                    continue;
+                auto fn_type = llvm::Intrinsic::getType(context, id, type);
+                if (!matches(id, fn_type))
+                    continue;
+                auto itype = llvm2impala(*typetable, fn_type);
+                if (!itype)
+                    continue;
+#if LLVM_VERSION_MAJOR >= 13
+                auto mangled = llvm::Intrinsic::getNameNoUnnamedTypes(id, type);
+#else
+                auto mangled = llvm::Intrinsic::getName(id, type);
+#endif
+                emit(mangled, impala_name(mangled), itype);
+                instantiated = true;
+            }
+
+            if (!instantiated) {
                 std::cout << thorin::endl;
-                auto fn = itype->as<impala::FnType>();
-                std::cout << "fn \"" << llvm_name << "\" " << name << "(";
-                for (size_t i = 0, e = fn->num_params()-1; i != e; ++i) {
-                    std::cout << fn->param(i);
-                    if (i != e-1)
-                        std::cout << ", ";
-                }
-                if (fn->return_type()->isa<impala::NoRetType>())
-                    std::cout << ") -> !;";
-                else
-                    std::cout << ") -> " << fn->return_type() << ';';
+                std::cout << "// fn \"" << llvm_name << "\" " << name;
+                std::cout << " (...) -> (...); // is overloaded";
             }
+        } else {
+            if (auto itype = llvm2impala(*typetable, llvm::Intrinsic::getType(context, id)))
+                emit(llvm_name, name, itype);
         }
     }
     std::cout << thorin::down << thorin::endl << '}' << thorin::endl;
 }
 
+/// The non-empty items of the comma-separated @p list.
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> result;
+    std::istringstream stream(list);
+    for (std::string item; std::getline(stream, item, ',');) {
+        if (!item.empty())
+            result.push_back(item);
+    }
+    return result;
+}
+
+/// All combinations of the comma-separated element types @p elems (f16, f32, f64, i1, i8, i16, i32, i64) and vector widths @p widths.
+std::vector<llvm::Type*> overload_types(llvm::LLVMContext& context, const std::string& elems, const std::string& widths) {
+    std::vector<llvm::Type*> result;
+    for (auto&& elem : split(elems)) {
+        llvm::Type* type = nullptr;
+        if      (elem == "f16") type = llvm::Type::getHalfTy(context);
+        else if (elem == "f32") type = llvm::Type::getFloatTy(context);
+        else if (elem == "f64") type = llvm::Type::getDoubleTy(context);
+        else if (elem[0] == 'i') type = llvm::Type::getIntNTy(context, std::stoi(elem.substr(1)));
+        else
+            throw std::invalid_argument("unknown element type '" + elem + "'");
+
+        for (auto&& width : split(widths)) {
+            auto n = std::stoi(width);
+            if (n == 1)
+                result.push_back(type);
+            else
+#if LLVM_VERSION_MAJOR >= 11
+                result.push_back(llvm::FixedVectorType::get(type, n));
+#else
+                result.push_back(llvm::VectorType::get(type, n));
+#endif
+        }
+    }
+    return result;
+}
+
+/**
+ * Whether intrinsic @p id has exactly one overloaded type and @p type fits its constraints.
+ * @c Intrinsic::getType casts the overloaded type to a vector for the types derived from its elements - so these exclude scalars.
+ */
+bool accepts(llvm::Intrinsic::ID id, llvm::Type* type) {
+    typedef llvm::Intrinsic::IITDescriptor IIT;
+    llvm::SmallVector<IIT, 8> table;
+    llvm::Intrinsic::getIntrinsicInfoTableEntries(id, table);
+
+    std::set<unsigned> overloaded;
+    for (auto&& entry : table) {
+        switch (entry.Kind) {
+            case IIT::HalfVecArgument:
+            case IIT::PtrToElt:
+#if LLVM_VERSION_MAJOR >= 9
+            case IIT::VecElementArgument:
+            case IIT::Subdivide2Argument:
+            case IIT::Subdivide4Argument:
+            case IIT::VecOfBitcastsToInt:
+#endif
+                if (!type->isVectorTy())
+                    return false;
+                break;
+            case IIT::Argument:
+                overloaded.insert(entry.getArgumentNumber());
+                switch (entry.getArgumentKind()) {
+                    case IIT::AK_AnyInteger: if (!type->isIntOrIntVectorTy()) return false; break;
+                    case IIT::AK_AnyFloat:   if (!type->isFPOrFPVectorTy())   return false; break;
+                    case IIT::AK_AnyVector:  if (!type->isVectorTy())         return false; break;
+                    case IIT::AK_AnyPointer: return false;
+                    default: break;
+                }
+                break;
+            case IIT::VecOfAnyPtrsToElt:
+                return false; // introduces a second overloaded type
+            default:
+                break;
+        }
+    }
+
+    return overloaded.size() == 1;
+}
+
+/// Whether @p fn_type is a valid signature of intrinsic @p id - like the verifier checks it; @c Intrinsic::getType does not.
+bool matches(llvm::Intrinsic::ID id, llvm::FunctionType* fn_type) {
+#if LLVM_VERSION_MAJOR >= 9
+    llvm::SmallVector<llvm::Intrinsic::IITDescriptor, 8> table;
+    llvm::Intrinsic::getIntrinsicInfoTableEntries(id, table);
+    llvm::ArrayRef<llvm::Intrinsic::IITDescriptor> entries = table;
+    llvm::SmallVector<llvm::Type*, 4> overloaded;
+    if (llvm::Intrinsic::matchIntrinsicSignature(fn_type, entries, overloaded) != llvm::Intrinsic::MatchIntrinsicTypes_Match)
+        return false;
+    return !llvm::Intrinsic::matchIntrinsicVarArg(fn_type->isVarArg(), entries);
+#else
+    (void)id;
+    (void)fn_type;
+    return true;
+#endif
+}
+
 const impala::Type* llvm2impala(impala::TypeTable& tt, llvm::Type* type) {
     if (auto int_type = llvm::dyn_cast<llvm::IntegerType>(type)) {
         switch (int_type->getBitWidth()) {
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+
+import json
+import math
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from perform import EXE, EMIT_EXT, RunImpalaCompile, LinkFakeRuntime, TestFile, search_in_path
+
+
+BENCHMARKS = ['aobench', 'fannkuch', 'fasta', 'mandelbrot', 'meteor', 'nbody', 'pidigits', 'regex', 'reverse', 'spectral',
+              'aobench_parallel', 'mandelbrot_parallel', 'mandelbrot_simd', 'nbody_simd', 'spectral_parallel', 'spectral_simd',
+              'checked_sum', 'checked_sum_hinted', 'simd_reduce']
+# benchmarks without an .in file that read the output of another one
+INPUT_FROM = {'reverse': 'fasta'}
+METRICS = ['wall', 'user', 'sys', 'maxrss']
+
+
+class Benchmark(object):
+    def __init__(self, name, directory, tempdir):
+        self.name = name
+        self.file = TestFile(os.path.join(directory, name + '.impala'), tempdir)
+        with open(self.file.filename()) as source:
+            tokens = source.readline().split()
+        self.link_flags = [token for token in tokens if token.startswith('-l')]
+        self.args = [token.strip('"') for token in tokens if token.startswith('"')]
+
+    def build(self, compile, link):
+        if not os.path.isdir(self.file.dirname()):
+            os.makedirs(self.file.dirname())
+        return compile(self.file, self.link_flags) and link(self.file, self.link_flags)
+
+    def input(self):
+        filename = self.file.source('.in')
+        if filename is None and self.name in INPUT_FROM:
+            filename = self.file.intermediate('.' + INPUT_FROM[self.name] + '.in')
+        return filename
+
+    def expected_output(self):
+        filename = self.file.source('.out')
+        if filename is None:
+            return None
+        with open(filename, 'rb') as file:
+            return file.read()
+
+    def run(self, timeout, threads=None):
+        """Runs the benchmark once - with ANYDSL_NUM_THREADS=threads if given; returns its stdout and a sample with wall/user/sys time in seconds and max RSS in KiB."""
+        stdin = self.input()
+        env = dict(os.environ)
+        if threads is not None:
+            env['ANYDSL_NUM_THREADS'] = str(threads)
+        timed_out = []
+        with open(stdin, 'rb') if stdin else open(os.devnull, 'rb') as input, tempfile.TemporaryFile() as output:
+            start = time.perf_counter()
+            process = subprocess.Popen([self.file.intermediate(EXE)] + self.args, stdin=input, stdout=output, stderr=subprocess.DEVNULL, env=env)
+            timer = threading.Timer(timeout, lambda: timed_out.append(process.kill()))
+            timer.start()
+            if hasattr(os, 'wait4'):
+                # reap the child ourselves to get its own resource usage
+                _, status, usage = os.wait4(process.pid, 0)
+                process.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -os.WTERMSIG(status)
+            else:
+                process.wait()
+                usage = None
+            wall = time.perf_counter() - start
+            timer.cancel()
+            output.seek(0)
+            stdout = output.read()
+
+        if timed_out:
+            raise RuntimeError(self.name + ' timed out after ' + str(timeout) + ' seconds')
+        if process.returncode != 0:
+            raise RuntimeError(self.name + ' exited with returncode ' + str(process.returncode))
+
+        sample = {'wall': wall}
+        if usage is not None:
+            # ru_maxrss is in bytes on macOS and in KiB elsewhere
+            maxrss = usage.ru_maxrss // 1024 if sys.platform == 'darwin' else usage.ru_maxrss
+            sample.update({'user': usage.ru_utime, 'sys': usage.ru_stime, 'maxrss': maxrss})
+        return stdout, sample
+
+
+def median_confidence_interval(samples, z=1.96):
+    """Distribution-free confidence interval of the median based on order statistics; z=1.96 gives 95%."""
+    ordered = sorted(samples)
+    n = len(ordered)
+    half_width = z * math.sqrt(n) / 2
+    lower = max(0, int(math.floor(n / 2 - half_width)))
+    upper = min(n - 1, int(math.ceil(n / 2 + half_width)) - 1)
+    return ordered[lower], ordered[max(lower, upper)]
+
+
+def summarize(samples):
+    summary = {}
+    for metric in METRICS:
+        values = [sample[metric] for sample in samples if metric in sample]
+        if not values:
+            continue
+        lower, upper = median_confidence_interval(values)
+        summary[metric] = {
+            'median': statistics.median(values),
+            'ci_lower': lower,
+            'ci_upper': upper,
+            'mean': statistics.mean(values),
+            'stdev': statistics.stdev(values) if len(values) > 1 else 0.0,
+            'min': min(values),
+            'max': max(values),
+            'samples': values,
+        }
+    return summary
+
+
+def compare(results, baseline, threshold, metrics):
+    """Returns the list of regressions: medians more than threshold above the baseline whose confidence intervals do not overlap."""
+    regressions = []
+    for name, summary in sorted(results.items()):
+        for metric in metrics:
+            if name not in baseline or metric not in baseline[name] or metric not in summary:
+                continue
+            old, new = baseline[name][metric], summary[metric]
+            ratio = new['median'] / old['median'] if old['median'] > 0 else 1.0
+            significant = new['ci_lower'] > old['ci_upper']
+            verdict = 'REGRESSION' if ratio > 1 + threshold and significant else 'ok'
+            print('{:12} {:6} {:12.4f} -> {:12.4f} ({:+7.2%}) {}'.format(name, metric, old['median'], new['median'], ratio - 1, verdict))
+            if verdict != 'ok':
+                regressions.append((name, metric, ratio))
+    return regressions
+
+
+if __name__ == '__main__':
+    import argparse
+
+    config = {'IMPALA_BIN': None, 'CLANG_BIN': None, 'TEMP_DIR': os.getcwd(), 'LIBRTMOCK': None}
+    try:
+        import configDebug as config
+    except ImportError as e:
+        pass
+    try:
+        import configRelease as config
+    except ImportError as e:
+        pass
+    config = config if isinstance(config, dict) else vars(config)
+
+    directory = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'codegen', 'benchmarks')
+
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('benchmark',       nargs='*', help='benchmarks to run', default=BENCHMARKS)
+    parser.add_argument('-i', '--impala',  help='path to impala',                         type=str, default=config['IMPALA_BIN'])
+    parser.add_argument('-c', '--clang',   help='path to clang',                          type=str, default=config['CLANG_BIN'])
+    parser.add_argument(      '--impala-flag', help='additional flag(s) for impala',      type=str, default='')
+    parser.add_argument(      '--clang-flag',  help='additional flag(s) for clang',       type=str, default='-O2')
+    parser.add_argument(      '--emit',    help='what impala emits for clang to link',    choices=sorted(EMIT_EXT.keys()), default='obj')
+    parser.add_argument(      '--temp',    help='path to temp dir',                       type=str, default=config['TEMP_DIR'])
+    parser.add_argument(      '--rtmock',  help='path to rtmock',                         type=str, default=config['LIBRTMOCK'])
+    parser.add_argument('-n', '--runs',    help='measured runs per benchmark',            type=int, default=10)
+    parser.add_argument('-w', '--warmup',  help='unmeasured runs per benchmark; the first run always checks the output', type=int, default=1)
+    parser.add_argument('-t', '--compile-timeout', help='timeout for compiling a benchmark', type=int, default=60)
+    parser.add_argument('-r', '--run-timeout',     help='timeout for running a benchmark',   type=int, default=300)
+    parser.add_argument('-o', '--output',  help='write the results as JSON to this file', type=str, default=None)
+    parser.add_argument('-b', '--baseline', help='compare against results previously written with --output', type=str, default=None)
+    parser.add_argument(      '--threshold', help='relative slowdown of the median that counts as regression', type=float, default=0.05)
+    parser.add_argument(      '--threads', help='run each benchmark once per number of runtime threads; results are named <benchmark>@<threads>', type=int, nargs='+', default=None)
+    parser.add_argument(      '--metric',  help='metrics to compare against the baseline', nargs='+', choices=METRICS, default=['wall'])
+    args = parser.parse_args()
+
+    if args.impala is None:
+        args.impala = search_in_path('impala')
+    if args.clang is None:
+        args.clang = search_in_path('clang')
+    if args.rtmock is None:
+        print('Unable to determine the path to librtmock')
+        sys.exit(2)
+    if args.runs < 2:
+        print('At least two runs are needed for confidence intervals')
+        sys.exit(2)
+
+    impala_flags = [arg.strip() for arg in args.impala_flag.split(' ')] if len(args.impala_flag) else []
+    clang_flags = [arg.strip() for arg in args.clang_flag.split(' ')] if len(args.clang_flag) else []
+    compile = RunImpalaCompile(args.impala, impala_flags, timeout=args.compile_timeout, emit=args.emit)
+    link = LinkFakeRuntime(args.clang, args.rtmock, clang_flags, emit=args.emit)
+
+    benchmarks = [Benchmark(name, directory, args.temp) for name in args.benchmark]
+    # producers have to run before their consumers
+    benchmarks.sort(key=lambda benchmark: benchmark.name not in INPUT_FROM.values())
+
+    results = {}
+    failed = False
+    for benchmark in benchmarks:
+        print('Benchmarking', benchmark.name)
+        if not benchmark.build(compile, link):
+            print('Building', benchmark.name, 'failed.')
+            failed = True
+            continue
+
+        try:
+            stdout, _ = benchmark.run(args.run_timeout)
+            expected = benchmark.expected_output()
+            if expected is not None and expected != stdout:
+                print(benchmark.name, 'generated invalid output')
+                failed = True
+                continue
+            for consumer, producer in INPUT_FROM.items():
+                if producer == benchmark.name:
+                    with open(benchmark.file.intermediate('.' + producer + '.in'), 'wb') as file:
+                        file.write(stdout)
+
+            for threads in args.threads or [None]:
+                name = benchmark.name if threads is None else '{}@{}'.format(benchmark.name, threads)
+                for _ in range(args.warmup - 1):
+                    benchmark.run(args.run_timeout, threads)
+                samples = [benchmark.run(args.run_timeout, threads)[1] for _ in range(args.runs)]
+
+                results[name] = summarize(samples)
+                wall = results[name]['wall']
+                print('{:12} median {:.4f}s  95% CI [{:.4f}s, {:.4f}s]  stdev {:.4f}s'.format(name, wall['median'], wall['ci_lower'], wall['ci_upper'], wall['stdev']))
+        except RuntimeError as e:
+            print(e)
+            failed = True
+            continue
+
+    if args.output is not None:
+        with open(args.output, 'w') as file:
+            json.dump({'runs': args.runs, 'warmup': args.warmup, 'impala_flags': impala_flags, 'clang_flags': clang_flags, 'results': results}, file, indent=2, sort_keys=True)
+
+    if args.baseline is not None:
+        with open(args.baseline) as file:
+            baseline = json.load(file)['results']
+        if compare(results, baseline, args.threshold, args.metric):
+            failed = True
+
+    print('FAILED' if failed else 'PASSED')
+    sys.exit(1 if failed else 0)
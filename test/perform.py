@@ -7,6 +7,8 @@ import sys
 
 EXE = '.exe' if sys.platform == 'win32' else ''
 LIBC = '' #'-lmsvcrt' if sys.platform == 'win32' else ''
+# rtmock's thread pool needs the C++ standard library and threads
+RTMOCK_LIBS = [] if sys.platform == 'win32' else ['-lc++' if sys.platform == 'darwin' else '-lstdc++', '-pthread']
 
 
 class TestMethod(object):
@@ -61,13 +63,18 @@ class TestMethod(object):
         return None
 
 
+# extension of the CPU module for each of impala's -emit-* modes
+EMIT_EXT = {'obj': '.o', 'bc': '.bc', 'llvm': '.ll'}
+
+
 class RunImpalaCompile(TestMethod):
-    def __init__(self, impala, add_flags=[], timeout=None):
+    def __init__(self, impala, add_flags=[], timeout=None, emit='obj'):
         super().__init__(impala, timeout=timeout)
         self.flags = add_flags
+        self.emit = emit
 
     def __call__(self, testfile, addflags):
-        super().__call__(["-emit-llvm", "-O2", "-o", testfile.intermediate(), testfile.filename()] + self.flags)
+        super().__call__(["-emit-" + self.emit, "-O2", "-o", testfile.intermediate(), testfile.filename()] + self.flags)
 
         self.dump_output(testfile.intermediate('.log'))
 
@@ -87,14 +94,15 @@ class RunImpalaCompile(TestMethod):
         return True
 
 class LinkFakeRuntime(TestMethod):
-    def __init__(self, clang, runtime, add_flags=[]):
+    def __init__(self, clang, runtime, add_flags=[], emit='obj'):
         super().__init__(clang)
         self.runtime = runtime
         self.flags = add_flags
+        self.ext = EMIT_EXT[emit]
 
     def __call__(self, testfile, addflags):
         flags = self.flags + [flag for flag in addflags if flag.startswith('-l')]
-        super().__call__([testfile.intermediate('.ll'), LIBC, self.runtime, "-o", testfile.intermediate(EXE)] + flags)
+        super().__call__([testfile.intermediate(self.ext), LIBC, self.runtime, "-o", testfile.intermediate(EXE)] + RTMOCK_LIBS + flags)
 
         self.dump_output(None)
 
@@ -219,6 +227,7 @@ if __name__ == '__main__':
     parser.add_argument('-c', '--clang',           help='path to clang',                      type=str, default=config.CLANG_BIN)
     parser.add_argument(      '--impala-flag',     help='additional flag(s) for impala',      type=str, default='')
     parser.add_argument(      '--clang-flag',      help='additional flag(s) for clang',       type=str, default='')
+    parser.add_argument(      '--emit',            help='what impala emits for clang to link', choices=sorted(EMIT_EXT.keys()), default='obj')
     parser.add_argument(      '--temp',            help='path to temp dir',                   type=str, default=config.TEMP_DIR)
     parser.add_argument(      '--rtmock',          help='path to rtmock',                     type=str, default=config.LIBRTMOCK)
     parser.add_argument('-t', '--compile-timeout', help='timeout for compiling test case',    type=int, default=5)
@@ -245,8 +254,8 @@ if __name__ == '__main__':
 
     test_methods = {
         'codegen' : MultiStepPipeline(
-            RunImpalaCompile(args.impala, impala_flags, timeout=args.compile_timeout),
-            LinkFakeRuntime(args.clang, args.rtmock, clang_flags),
+            RunImpalaCompile(args.impala, impala_flags, timeout=args.compile_timeout, emit=args.emit),
+            LinkFakeRuntime(args.clang, args.rtmock, clang_flags, emit=args.emit),
             ExecuteTestOutput(timeout=args.run_timeout)
         )
     }
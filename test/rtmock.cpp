@@ -1,7 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #ifdef __cplusplus
 extern "C" {
@@ -67,10 +76,6 @@ void anydsl_aligned_free(void* ptr) {
     free(((void**)ptr)[-1]);
 }
 #endif
-void* anydsl_alloc(int32_t dev, int64_t size) {
-    // TODO: check whether aligned memory is actually necessary
-    return anydsl_aligned_malloc(size, 64);
-}
 
 // meteor printing
 void print_meteor_scnt(int cnt) {
@@ -121,10 +126,6 @@ int read(char* s, int bufsize) {
     return (fgets(s, bufsize, stdin)) ? 1 : 0;
 }
 
-void* impala_realloc(void* ptr, int size) {
-    return realloc(ptr, size);
-}
-
 void impala_memmove(char* dest, const char* src, int size) {
     std::memmove(dest, src, size);
 }
@@ -139,6 +140,343 @@ int forty_two() {
 #endif
 
 
+// work-stealing runtime for parallel, spawn, and sync of the CPU backend
+namespace {
+
+typedef std::function<void()> Task;
+
+/// Double-ended queue of one thread: the owner pushes and pops at the back, thieves steal at the front.
+class TaskQueue {
+public:
+    void push(Task task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+
+    bool pop(Task& task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+            return false;
+        task = std::move(tasks_.back());
+        tasks_.pop_back();
+        return true;
+    }
+
+    bool steal(Task& task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+            return false;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Task> tasks_;
+};
+
+/**
+ * Fixed set of worker threads, each with its own @p TaskQueue.
+ * Queue 0 belongs to all threads that are not workers, e.g. main; these threads help out while waiting for their tasks.
+ * The number of threads - including the one calling into the runtime - is taken from ANYDSL_NUM_THREADS and defaults to the number of hardware threads.
+ */
+class ThreadPool {
+public:
+    static ThreadPool& instance() {
+        static ThreadPool pool(num_threads_from_env());
+        return pool;
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    size_t num_threads() const { return queues_.size(); }
+
+    void push(Task task) {
+        queues_[index_ < 0 ? 0 : index_]->push(std::move(task));
+        ++pending_;
+        // a worker checks pending_ while holding mutex_, so passing it here makes sure the worker does not miss the notification
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cond_.notify_one();
+    }
+
+    /// Runs a task of the own queue or - if there is none - one stolen from another queue; returns whether there was a task.
+    bool run_one() {
+        size_t self = index_ < 0 ? 0 : index_;
+        Task task;
+        bool found = queues_[self]->pop(task);
+        for (size_t i = 1, e = queues_.size(); !found && i != e; ++i)
+            found = queues_[(self + i) % e]->steal(task);
+        if (!found)
+            return false;
+        --pending_;
+        task();
+        return true;
+    }
+
+    /// Runs tasks until @p done holds.
+    template<class Pred>
+    void help_until(Pred done) {
+        while (!done()) {
+            if (!run_one())
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    ThreadPool(size_t num_threads) {
+        for (size_t i = 0; i != num_threads; ++i)
+            queues_.emplace_back(new TaskQueue());
+        for (size_t i = 1; i != num_threads; ++i)
+            workers_.emplace_back([this, i] { work(int(i)); });
+    }
+
+    static size_t num_threads_from_env() {
+        if (auto env = getenv("ANYDSL_NUM_THREADS")) {
+            int n = atoi(env);
+            if (n > 0)
+                return n;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void work(int index) {
+        index_ = index;
+        while (true) {
+            if (run_one())
+                continue;
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this] { return stop_ || pending_ > 0; });
+            if (stop_)
+                return;
+        }
+    }
+
+    static thread_local int index_;
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<int64_t> pending_{0};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_ = false;
+};
+
+thread_local int ThreadPool::index_ = -1;
+
+struct ParallelFor {
+    void* args;
+    void (*body)(void*, int32_t, int32_t);
+    int32_t grain;
+    std::atomic<int64_t> remaining;
+};
+
+/// Splits [lower, upper) in halves down to the grain size; the upper halves are left for other threads to steal.
+void run_range(ParallelFor* parallel_for, int32_t lower, int32_t upper) {
+    auto& pool = ThreadPool::instance();
+    while (upper - lower > parallel_for->grain) {
+        int32_t middle = lower + (upper - lower) / 2;
+        pool.push([=] { run_range(parallel_for, middle, upper); });
+        upper = middle;
+    }
+    parallel_for->body(parallel_for->args, lower, upper);
+    parallel_for->remaining -= upper - lower;
+}
+
+std::mutex spawned_mutex;
+std::unordered_map<int32_t, std::shared_ptr<std::atomic<bool>>> spawned;
+int32_t next_spawned = 0;
+
+}
+
+/// @p num_threads only determines the granularity of the work; 1 runs the whole range on the calling thread, 0 picks the pool size.
+extern "C" void anydsl_parallel_for(int32_t num_threads, int32_t lower, int32_t upper, void* args, void* fun) {
+    auto body = reinterpret_cast<void (*)(void*, int32_t, int32_t)>(fun);
+    if (upper <= lower)
+        return;
+    if (num_threads == 1) {
+        body(args, lower, upper);
+        return;
+    }
+
+    auto& pool = ThreadPool::instance();
+    int64_t threads = num_threads > 0 ? num_threads : pool.num_threads();
+    ParallelFor parallel_for{args, body, int32_t(std::max(int64_t(1), (int64_t(upper) - lower) / (threads * 8))), {int64_t(upper) - lower}};
+    run_range(&parallel_for, lower, upper);
+    pool.help_until([&] { return parallel_for.remaining == 0; });
+}
+
+extern "C" int32_t anydsl_spawn_thread(void* args, void* fun) {
+    auto body = reinterpret_cast<void (*)(void*)>(fun);
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    int32_t id;
+    {
+        std::lock_guard<std::mutex> lock(spawned_mutex);
+        id = next_spawned++;
+        spawned[id] = done;
+    }
+    ThreadPool::instance().push([=] { body(args); *done = true; });
+    return id;
+}
+
+extern "C" void anydsl_sync_thread(int32_t id) {
+    std::shared_ptr<std::atomic<bool>> done;
+    {
+        std::lock_guard<std::mutex> lock(spawned_mutex);
+        auto i = spawned.find(id);
+        if (i == spawned.end())
+            return;
+        done = i->second;
+        spawned.erase(i);
+    }
+    ThreadPool::instance().help_until([&] { return bool(*done); });
+}
+
+// size-class allocator behind anydsl_alloc; ANYDSL_ALLOC=malloc switches to plain aligned malloc for comparison
+namespace {
+
+/**
+ * Each block is preceded by a 64-byte header that records its size class, so blocks stay 64-byte aligned and
+ * anydsl_release finds the pool without a lookup. Blocks of a class are carved out of 64-byte aligned slabs and
+ * recycled through a free list of the releasing thread. Blocks larger than the largest class bypass the pools.
+ */
+class Allocator {
+public:
+    static const size_t header_size = 64;
+    static const size_t min_class = 64;
+    static const size_t num_classes = 11; // 64 B .. 64 KiB
+    static const size_t slab_size = 256 * 1024;
+
+    static bool pooled() {
+        static const bool result = [] {
+            auto env = getenv("ANYDSL_ALLOC");
+            return !env || strcmp(env, "malloc") != 0;
+        }();
+        return result;
+    }
+
+    static void* alloc(size_t size) {
+        if (!pooled())
+            return anydsl_aligned_malloc(size, 64);
+
+        size_t index = size_class(size);
+        if (index == num_classes) {
+            auto block = static_cast<char*>(anydsl_aligned_malloc(header_size + size, 64));
+            if (!block)
+                return nullptr;
+            header(block + header_size) = Header{num_classes, size};
+            return block + header_size;
+        }
+
+        auto& pool = instance().pools_[index];
+        if (!pool.free)
+            pool.refill(class_size(index));
+        if (!pool.free)
+            return nullptr;
+        auto ptr = pool.free;
+        pool.free = pool.free->next;
+        header(ptr) = Header{index, class_size(index)};
+        return ptr;
+    }
+
+    static void release(void* ptr) {
+        if (!ptr)
+            return;
+        if (!pooled()) {
+            anydsl_aligned_free(ptr);
+            return;
+        }
+
+        size_t index = header(ptr).size_class;
+        if (index == num_classes) {
+            anydsl_aligned_free(static_cast<char*>(ptr) - header_size);
+            return;
+        }
+
+        auto& pool = instance().pools_[index];
+        auto block = static_cast<FreeBlock*>(ptr);
+        block->next = pool.free;
+        pool.free = block;
+    }
+
+    /// Usable size of a block returned by @p alloc.
+    static size_t size(void* ptr) { return header(ptr).size; }
+
+private:
+    struct Header {
+        size_t size_class;
+        size_t size;
+    };
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Pool {
+        FreeBlock* free = nullptr;
+
+        void refill(size_t size) {
+            size_t stride = header_size + size;
+            size_t num = std::max(size_t(1), slab_size / stride);
+            auto slab = static_cast<char*>(anydsl_aligned_malloc(num * stride, 64));
+            if (!slab)
+                return;
+            for (size_t i = num; i-- != 0;) {
+                auto block = reinterpret_cast<FreeBlock*>(slab + i * stride + header_size);
+                block->next = free;
+                free = block;
+            }
+        }
+    };
+
+    static Allocator& instance() {
+        static thread_local Allocator allocator;
+        return allocator;
+    }
+
+    static size_t size_class(size_t size) {
+        size_t index = 0;
+        while (index != num_classes && class_size(index) < size)
+            ++index;
+        return index;
+    }
+
+    static size_t class_size(size_t index) { return min_class << index; }
+    static Header& header(void* ptr) { return *reinterpret_cast<Header*>(static_cast<char*>(ptr) - header_size); }
+
+    Pool pools_[num_classes];
+};
+
+}
+
+extern "C" void* anydsl_alloc(int32_t, int64_t size) {
+    return Allocator::alloc(size);
+}
+
+extern "C" void anydsl_release(int32_t, void* ptr) {
+    Allocator::release(ptr);
+}
+
+extern "C" void* impala_realloc(void* ptr, int size) {
+    if (!Allocator::pooled())
+        return realloc(ptr, size);
+    if (!ptr)
+        return Allocator::alloc(size);
+    if (size_t(size) <= Allocator::size(ptr))
+        return ptr;
+    auto result = Allocator::alloc(size);
+    std::memcpy(result, ptr, Allocator::size(ptr));
+    Allocator::release(ptr);
+    return result;
+}
+
 // polyfill of non-standard drand48()
 #ifdef _MSC_VER
 
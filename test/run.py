@@ -12,6 +12,8 @@ import threading
 from collections import namedtuple
 import time
 
+from perform import RTMOCK_LIBS
+
 # more constants here
 UNHANDLED = -1
 PASSED = 0
@@ -227,7 +229,7 @@ def run_tests():
 
                 # invoke clang
                 try:
-                    cmd_clang = [args.clang, tmp_ll, 'rtmock.cpp', '-o', tmp_exe]
+                    cmd_clang = [args.clang, tmp_ll, 'rtmock.cpp', '-o', tmp_exe] + RTMOCK_LIBS
                     cmd_clang.extend(clang_args)
                     p = subprocess.run(cmd_clang, stderr=tmp_log_file, stdout=tmp_log_file, timeout=args.clang_timeout)
                 except subprocess.TimeoutExpired as timeout:
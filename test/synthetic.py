@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+
+"""Generates large synthetic Impala programs to measure how the compiler scales."""
+
+import os
+
+
+class Parameters(object):
+    def __init__(self, modules=1, functions=10, generic_depth=2, chain_length=8, match_arms=4, table_size=16, repeat_count=0):
+        self.modules = modules              # number of .impala files
+        self.functions = functions          # functions per module
+        self.generic_depth = generic_depth  # generic functions per module, each one calling the previous one
+        self.chain_length = chain_length    # binary operators in the expression chain of each function
+        self.match_arms = match_arms        # literal arms of the match in each function
+        self.table_size = table_size        # elements of the static literal table of each module
+        self.repeat_count = repeat_count    # elements of the repeated arrays [x, .. n] of each module - none if 0
+
+    def as_dict(self):
+        return dict(vars(self))
+
+
+OPERATORS = ['+', '-', '*', '^', '|', '&']
+
+
+def expression_chain(length, seed):
+    operands = ['a', 'b', 'x']
+    expr = 'a'
+    for i in range(length):
+        k = seed + i
+        operand = operands[k % len(operands)] if k % 2 else str(k % 97 + 1)
+        expr = '({} {} {})'.format(expr, OPERATORS[k % len(OPERATORS)], operand)
+    return expr
+
+
+def generate_module(m, p):
+    lines = ['// module {} of {}'.format(m, p.modules), '']
+
+    size = max(p.table_size, 1)
+    elements = ', '.join(str((m * 31 + i * 17) % 1000) for i in range(size))
+    lines.append('static table{}: [i32 * {}] = [{}];'.format(m, size, elements))
+    lines.append('')
+
+    if p.repeat_count > 0:
+        lines.append('static mut zeros{}: [i32 * {}] = [0, .. {}];'.format(m, p.repeat_count, p.repeat_count))
+        lines.append('')
+        lines.append('fn m{}_fill(i: i32) -> i32 {{'.format(m))
+        lines.append('    let mut buf = [i, .. {}];'.format(p.repeat_count))
+        lines.append('    let ones = [1, .. {}];'.format(p.repeat_count))
+        lines.append('    buf(i & 7) = 1;')
+        lines.append('    zeros{}(i & 3) = 2;'.format(m))
+        lines.append('    buf(i & 15) + ones(i & 31) + [i, .. {}](i & 63) + zeros{}(i & 3)'.format(p.repeat_count, m))
+        lines.append('}')
+        lines.append('')
+
+    lines.append('fn m{}_g0[T](x: T) -> T {{ x }}'.format(m))
+    for d in range(1, p.generic_depth):
+        lines.append('fn m{0}_g{1}[T](x: T) -> T {{ m{0}_g{2}(x) }}'.format(m, d, d - 1))
+    generic = 'm{}_g{}'.format(m, p.generic_depth - 1) if p.generic_depth > 0 else ''
+    lines.append('')
+
+    for f in range(p.functions):
+        name = 'm{}_f{}'.format(m, f)
+        lines.append('fn {}(a: i32, b: i32) -> i32 {{'.format(name))
+        lines.append('    let x = {}(b + table{}({}));'.format(generic, m, f % size))
+        lines.append('    let y = {};'.format(expression_chain(p.chain_length, m * p.functions + f)))
+        lines.append('    let z = match a & {} {{'.format(max(p.match_arms, 1) * 2 - 1))
+        for arm in range(p.match_arms):
+            lines.append('        {} => y {} {},'.format(arm, OPERATORS[arm % len(OPERATORS)], arm + 1))
+        lines.append('        _ => y + x')
+        lines.append('    };')
+        # every function calls the previous one so that none of them is unreachable
+        if f > 0:
+            lines.append('    if a > 0 {{ z + m{}_f{}(a - 1, z) }} else {{ z }}'.format(m, f - 1))
+        else:
+            lines.append('    z')
+        lines.append('}')
+        lines.append('')
+
+    return '\n'.join(lines)
+
+
+def generate_main(p):
+    calls = ' + '.join('m{}_f{}(1, 2)'.format(m, p.functions - 1) for m in range(p.modules)) if p.functions > 0 else '0'
+    if p.repeat_count > 0:
+        calls += ''.join(' + m{}_fill({})'.format(m, m) for m in range(p.modules))
+    return 'fn main() -> i32 {{\n    if {} == 0 {{ 1 }} else {{ 0 }}\n}}\n'.format(calls)
+
+
+def generate(directory, p):
+    """Writes the modules of a program with parameters p to directory; returns their file names - main is in the first one."""
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    files = []
+    for m in range(p.modules):
+        filename = os.path.join(directory, 'synthetic{}.impala'.format(m))
+        with open(filename, 'w') as file:
+            file.write(generate_module(m, p))
+            if m == 0:
+                file.write(generate_main(p))
+        files.append(filename)
+    return files
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('directory',           help='where to write the .impala files')
+    parser.add_argument('--modules',           help='number of .impala files',                  type=int, default=1)
+    parser.add_argument('--functions',         help='functions per module',                     type=int, default=10)
+    parser.add_argument('--generic-depth',     help='chain of generic functions per module',    type=int, default=2)
+    parser.add_argument('--chain-length',      help='binary operators per expression chain',    type=int, default=8)
+    parser.add_argument('--match-arms',        help='literal arms per match',                   type=int, default=4)
+    parser.add_argument('--table-size',        help='elements of the static table per module',  type=int, default=16)
+    parser.add_argument('--repeat-count',      help='elements of the repeated array per module', type=int, default=0)
+    args = parser.parse_args()
+
+    for filename in generate(args.directory, Parameters(args.modules, args.functions, args.generic_depth, args.chain_length, args.match_arms, args.table_size, args.repeat_count)):
+        print(filename)
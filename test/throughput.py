@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+
+"""Measures time and growth of the peak memory of each phase of impala on synthetic programs of growing size."""
+
+import json
+import math
+import os
+import re
+import statistics
+import subprocess
+import sys
+
+from perform import search_in_path
+from synthetic import Parameters, generate
+
+
+PHASE = re.compile(r'^phase (\S+) ([0-9.e+-]+) ms (\d+) KiB$')
+
+
+def compile(impala, files, flags, timeout):
+    """Compiles files with -time-phases; returns a dict from phase to (ms, KiB the peak memory grew by)."""
+    completed = subprocess.run([impala, '-time-phases'] + flags + files, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, timeout=timeout)
+    if completed.returncode != 0:
+        raise RuntimeError(str(completed.stderr, 'utf-8', 'ignore'))
+    phases = {}
+    for line in str(completed.stderr, 'utf-8', 'ignore').splitlines():
+        match = PHASE.match(line.strip())
+        if match:
+            phases[match.group(1)] = (float(match.group(2)), int(match.group(3)))
+    if not phases:
+        raise RuntimeError('impala did not report any phases - is it recent enough to know -time-phases?')
+    return phases
+
+
+def exponent(sizes, times):
+    """Slope of the least-squares fit of log(time) over log(size): 1 means linear, 2 quadratic."""
+    points = [(math.log(size), math.log(time)) for size, time in zip(sizes, times) if size > 0 and time > 0]
+    if len(points) < 2:
+        return None
+    mx = statistics.mean(x for x, _ in points)
+    my = statistics.mean(y for _, y in points)
+    sxx = sum((x - mx) ** 2 for x, _ in points)
+    if sxx == 0:
+        return None
+    return sum((x - mx) * (y - my) for x, y in points) / sxx
+
+
+if __name__ == '__main__':
+    import argparse
+
+    config = {'IMPALA_BIN': None, 'TEMP_DIR': os.getcwd()}
+    try:
+        import configDebug as config
+    except ImportError as e:
+        pass
+    try:
+        import configRelease as config
+    except ImportError as e:
+        pass
+    config = config if isinstance(config, dict) else vars(config)
+
+    defaults = Parameters()
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-i', '--impala',      help='path to impala', type=str, default=config['IMPALA_BIN'])
+    parser.add_argument(      '--impala-flag', help='flag(s) for impala besides -time-phases', type=str, default='-emit-llvm -O2')
+    parser.add_argument(      '--temp',        help='path to temp dir', type=str, default=config['TEMP_DIR'])
+    parser.add_argument(      '--vary',        help='parameter to scale', choices=sorted(defaults.as_dict().keys()), default='functions')
+    parser.add_argument(      '--sizes',       help='values of the varied parameter', type=int, nargs='+', default=[100, 200, 400, 800, 1600])
+    parser.add_argument('-n', '--runs',        help='compilations per size; the median is reported', type=int, default=3)
+    parser.add_argument('-t', '--timeout',     help='timeout for one compilation', type=int, default=600)
+    parser.add_argument(      '--superlinear', help='report phases whose time grows with at least this exponent', type=float, default=1.3)
+    parser.add_argument('-o', '--output',      help='write the measurements as JSON to this file', type=str, default=None)
+    for name, value in sorted(defaults.as_dict().items()):
+        parser.add_argument('--' + name.replace('_', '-'), help='value of ' + name + ' unless varied', type=int, default=value)
+    args = parser.parse_args()
+
+    if args.impala is None:
+        args.impala = search_in_path('impala')
+
+    flags = [arg.strip() for arg in args.impala_flag.split(' ')] if len(args.impala_flag) else []
+    directory = os.path.join(args.temp, 'throughput')
+
+    measurements = []
+    for size in args.sizes:
+        parameters = {name: getattr(args, name) for name in defaults.as_dict()}
+        parameters[args.vary] = size
+        files = generate(directory, Parameters(**parameters))
+
+        runs = []
+        for _ in range(args.runs):
+            try:
+                runs.append(compile(args.impala, files, flags + ['-o', os.path.join(directory, 'synthetic')], args.timeout))
+            except (RuntimeError, subprocess.TimeoutExpired) as e:
+                print('Compiling', args.vary, '=', size, 'failed:', e)
+                sys.exit(1)
+
+        phases = {}
+        for phase in runs[0]:
+            phases[phase] = {
+                'ms': statistics.median(run[phase][0] for run in runs),
+                'peak_growth_kib': max(run[phase][1] for run in runs),
+            }
+        measurements.append({'size': size, 'parameters': parameters, 'phases': phases})
+
+        print('{} = {}'.format(args.vary, size))
+        for phase, result in phases.items():
+            print('    {:10} {:12.3f} ms {:10} KiB'.format(phase, result['ms'], result['peak_growth_kib']))
+
+    exponents = {}
+    print('scaling exponents over', args.vary)
+    for phase in measurements[0]['phases']:
+        points = [(m['size'], m['phases'][phase]['ms']) for m in measurements if phase in m['phases']]
+        k = exponent([size for size, _ in points], [ms for _, ms in points])
+        exponents[phase] = k
+        if k is not None:
+            print('    {:10} {:6.2f}{}'.format(phase, k, '  SUPERLINEAR' if k >= args.superlinear else ''))
+
+    if args.output is not None:
+        with open(args.output, 'w') as file:
+            json.dump({'vary': args.vary, 'flags': flags, 'measurements': measurements, 'exponents': exponents}, file, indent=2, sort_keys=True)